@@ -52,7 +52,10 @@
 #pragma once
 #include "utils.h"
 #include "ydlidar_driver.h"
+#include "scan_history.h"
+#include "lidar_profile.h"
 #include <math.h>
+#include <future>
 
 using namespace ydlidar;
 
@@ -323,6 +326,33 @@ using namespace ydlidar;
  * @endcode
  */
 
+/**
+ * @brief Bring-up stages reported by CYdLidar::setProgressCallback.
+ */
+enum BringUpStage {
+  BRINGUP_CONNECTING = 0,   ///< opening the serial port
+  BRINGUP_CHECKING_HEALTH,  ///< reading the health status
+  BRINGUP_READING_INFO,     ///< device information, sample rate, frequency, zero angle
+  BRINGUP_INITIALIZED,      ///< CYdLidar::initialize succeeded
+  BRINGUP_STARTING_SCAN,    ///< starting the motor and the scan
+  BRINGUP_CHECKING_SCAN,    ///< measuring the sample rate from the first scans
+  BRINGUP_SCANNING,         ///< CYdLidar::turnOn succeeded
+  BRINGUP_FAILED,           ///< CYdLidar::initialize or CYdLidar::turnOn failed
+};
+
+/**
+ * @brief Settings CYdLidar::reconfigure can change while scanning.
+ * @see CYdLidar::getSettings
+ */
+struct LidarSettings {
+  float scan_frequency;       ///< [Hz]
+  int sample_rate;            ///< [K]
+  float min_range;            ///< [m]
+  float max_range;            ///< [m]
+  float min_angle;            ///< [°]
+  float max_angle;            ///< [°]
+  std::vector<float> ignore;  ///< ignored sectors, pairs of [°]
+};
 
 
 /// Provides a platform independent class to for LiDAR development.
@@ -510,6 +540,59 @@ class YDLIDAR_API CYdLidar {
    * @see CYdLidar::setIgnoreArray and CYdLidar::getIgnoreArray
    */
   PropertyBuilderByName(std::vector<float>, IgnoreArray, private);
+  /**
+   * @brief Set and Get LiDAR scan seam angle.
+   * @note The angle at which a revolution is closed and published.\n
+   * Set it just after the safety-critical sector has been swept,
+   * so that sector is always the freshest part of every scan.\n
+   * A value out of range(default: 360) closes the revolution at the device sync bit.
+   * @remarks unit: degree, Range:-180~180, same frame as CYdLidar::setMinAngle
+   * @see CYdLidar::setScanSeamAngle and CYdLidar::getScanSeamAngle
+   */
+  PropertyBuilderByName(float, ScanSeamAngle, private);
+  /**
+   * @brief Set and Get LiDAR rolling window angle bins.
+   * @note When greater than zero, the driver keeps a continuously updated
+   * 360 degree ring of the latest sample at each angle bin,
+   * refreshed package by package.\n
+   * 0(default) disables the rolling window. Takes effect at CYdLidar::turnOn.
+   * @see CYdLidar::getScanWindow
+   * @see CYdLidar::setScanWindowBins and CYdLidar::getScanWindowBins
+   */
+  PropertyBuilderByName(int, ScanWindowBins, private);
+  /**
+   * @brief Set and Get LiDAR scan history duration.
+   * @note When greater than zero, every scan returned by
+   * CYdLidar::doProcessSimple is also kept, once and shared, in a time indexed
+   * history covering that many seconds.\n
+   * 0(default) disables the history. Takes effect at CYdLidar::turnOn.
+   * @remarks unit: s
+   * @see CYdLidar::getNearestScan, CYdLidar::getScans and CYdLidar::getRangeAt
+   * @see CYdLidar::setScanHistoryDuration and CYdLidar::getScanHistoryDuration
+   */
+  PropertyBuilderByName(float, ScanHistoryDuration, private);
+  /**
+   * @brief Set and Get LiDAR threadless mode.
+   * @note When true(default: false), no parsing thread is started.\n
+   * Poll CYdLidar::getFileDescriptor for readability in your own event loop
+   * and call CYdLidar::processReadable when it fires, then fetch completed
+   * scans with CYdLidar::doProcessSimple from the same thread.\n
+   * Must be set before CYdLidar::initialize.
+   * @see CYdLidar::setThreadless and CYdLidar::getThreadless
+   */
+  PropertyBuilderByName(bool, Threadless, private);
+  /**
+   * @brief Set and Get LiDAR parsing thread scheduling options.
+   * @note SCHED_FIFO/SCHED_RR priority, CPU affinity and a preallocated stack,
+   * applied when the parsing thread is created. To keep the whole process
+   * resident, call Thread::lockProcessMemory once at start up.\n
+   * Real-time priority needs CAP_SYS_NICE or RLIMIT_RTPRIO; on failure a clear
+   * error is printed and the thread runs with default scheduling.\n
+   * Must be set before CYdLidar::initialize.
+   * @see ThreadOptions
+   * @see CYdLidar::setThreadOptions and CYdLidar::getThreadOptions
+   */
+  PropertyBuilderByName(ThreadOptions, ThreadOptions, private);
 
   PropertyBuilderByName(float, OffsetTime, private);
   /**
@@ -551,6 +634,47 @@ class YDLIDAR_API CYdLidar {
   * @see CYdLidar::setLidarType and CYdLidar::getLidarType
   */
   PropertyBuilderByName(int, LidarType, private);
+  /**
+   * @brief Set and Get LiDAR profile cache directory.
+   * @note When not empty, the state negotiated by a full
+   * CYdLidar::initialize and CYdLidar::turnOn (model, firmware, sample rate,
+   * scan frequency, points per revolution, zero offset angle) is saved there,
+   * one file per serial number.\n
+   * The directory must exist. ""(default) disables the cache.
+   * @see CYdLidar::setFastStart
+   * @see CYdLidar::setProfileCacheDir and CYdLidar::getProfileCacheDir
+   */
+  PropertyBuilderByName(std::string, ProfileCacheDir, private);
+  /**
+   * @brief Set and Get LiDAR fast start.
+   * @note When true(default: false) and the cache holds a profile for this
+   * device and the same SampleRate/ScanFrequency/SingleChannel,
+   * CYdLidar::initialize only reads the device information and
+   * CYdLidar::turnOn starts scanning without the abnormal check.\n
+   * The profile is then validated from the first scans: on a mismatch it is
+   * deleted, and CYdLidar::doProcessSimple turns the LiDAR off and reports a
+   * hardware error, so the next CYdLidar::initialize negotiates in full.\n
+   * Single channel LiDARs are looked up by port, their serial number is
+   * checked in-stream.
+   * @see CYdLidar::setFastStart and CYdLidar::getFastStart
+   */
+  PropertyBuilderByName(bool, FastStart, private);
+  /**
+   * @brief Set and Get serial number of the LiDAR to open.
+   * @note When not empty, CYdLidar::initialize looks the LiDAR up among the
+   * ports of the known USB serial adapters and sets SerialPort itself.
+   * Device names change between boots, so the physical USB port each LiDAR
+   * was found on is remembered in ProfileCacheDir, and only that port is
+   * tried. Otherwise, or if it holds another LiDAR, all candidate ports are
+   * probed in parallel, skipping ports other CYdLidar instances use. Build
+   * with USE_LOCK_FILE to keep off ports other processes use.\n
+   * Single channel LiDARs report their serial number in-stream only: probing
+   * them takes a few seconds, and a remembered port is trusted and checked
+   * once scanning. ""(default) opens SerialPort.
+   * @see CYdLidar::getSerialNumber
+   * @see CYdLidar::setDeviceSerialNumber and CYdLidar::getDeviceSerialNumber
+   */
+  PropertyBuilderByName(std::string, DeviceSerialNumber, private);
 
  public:
   CYdLidar(); //!< Constructor
@@ -561,6 +685,20 @@ class YDLIDAR_API CYdLidar {
    */
   bool initialize();  //!< Attempts to connect and turns the laser on. Raises an exception on error.
 
+  /*!
+   * @brief autoDetect
+   * Identifies the LiDAR on CYdLidar::getSerialPort before
+   * CYdLidar::initialize, and sets SerialBaudrate, SingleChannel and
+   * LidarType to match it.
+   * @note A silent single channel LiDAR is only found once its motor is
+   * started, which takes most of the timeout. Its model cannot be read, so
+   * LidarType is left unchanged for it.
+   * @param timeout maximum detection time [ms]
+   * @return false if the port is already connected or no LiDAR was found
+   * @see YDlidarDriver::detectLidar
+   */
+  bool autoDetect(uint32_t timeout = YDlidarDriver::DEFAULT_DETECT_TIMEOUT);
+
   // Return true if laser data acquistion succeeds, If it's not
   bool doProcessSimple(LaserScan &outscan,
                        bool &hardwareError);
@@ -571,9 +709,316 @@ class YDLIDAR_API CYdLidar {
   //Turn off the motor enable and close the scan
   bool  turnOff(); //!< See base class docs
 
+  /*!
+   * @brief standby
+   * Stops scanning and the motor, and enables the low-power mode where the
+   * model supports it. The connection and everything negotiated by
+   * CYdLidar::initialize and CYdLidar::turnOn are kept, so
+   * CYdLidar::resume is much faster than CYdLidar::turnOn.\n
+   * CYdLidar::doProcessSimple returns false without a hardware error
+   * meanwhile.
+   * @return false if the LiDAR is not scanning
+   */
+  bool standby();
+
+  /*!
+   * @brief resume
+   * Leaves standby: restarts the motor and the scan without the abnormal
+   * check, and holds the first scans against the negotiated state like after
+   * a reconnect.
+   * @return false if not in standby or the scan could not be started
+   */
+  bool resume();
+
+  //! whether CYdLidar::standby is in effect
+  bool isStandby() const;
+
+  //! the current reconfigurable settings
+  LidarSettings getSettings() const;
+
+  /*!
+   * @brief reconfigure
+   * Applies new settings with as little downtime as possible.
+   * @note Range, angle limits and ignore sectors are host-side. They are
+   * swapped as a whole between two scans, with no gap.\n
+   * A new scan frequency or sample rate needs the LiDAR's commands. The scan
+   * is paused, the motor keeps turning, only the commands for what changed
+   * are sent, and the scan continues once the speed is stable. Scan
+   * consumers stay registered, and CYdLidar::doProcessSimple returns false
+   * without a hardware error meanwhile. Not available on single channel
+   * LiDARs.\n
+   * Every call changes LaserConfig::generation, so the first scan with the
+   * new settings can be told apart.
+   * @param settings new settings
+   * @return false if the LiDAR settings could not be applied; host-side
+   * settings are applied regardless
+   */
+  bool reconfigure(const LidarSettings &settings);
+
+  /*!
+   * @brief getMotorState
+   * @param running whether the motor turns
+   * @return false while scanning, or if the model does not report it
+   */
+  bool getMotorState(bool &running);
+
   //Turn off lidar connection
   void disconnecting(); //!< Closes the comms with the laser. Shouldn't have to be directly needed by the user
 
+  typedef std::function<void(BringUpStage stage)> ProgressCallback;
+
+  /*!
+   * @brief setProgressCallback
+   * Called as CYdLidar::initialize and CYdLidar::turnOn go through the
+   * bring-up stages, on the thread running them.
+   * @param callback progress callback
+   */
+  void setProgressCallback(const ProgressCallback &callback);
+
+  /*!
+   * @brief initializeAsync
+   * Runs CYdLidar::initialize on a worker thread, once the previous
+   * asynchronous call finished.
+   * @note Do not call other methods until the future is ready, except the
+   * *Async ones. The destructor waits for it.
+   * @return result of CYdLidar::initialize
+   * @see CYdLidar::setProgressCallback
+   */
+  std::shared_future<bool> initializeAsync();
+
+  /*!
+   * @brief turnOnAsync
+   * Runs CYdLidar::turnOn on a worker thread, once the previous asynchronous
+   * call finished. Fails without trying if that call failed, so
+   * initializeAsync and turnOnAsync can be issued back to back.
+   * @note Do not call other methods until the future is ready, except the
+   * *Async ones. The destructor waits for it.
+   * @return result of CYdLidar::turnOn
+   * @see CYdLidar::setProgressCallback
+   */
+  std::shared_future<bool> turnOnAsync();
+
+  /*!
+   * @brief waitAsync
+   * Waits for the last asynchronous call to finish, if any.
+   */
+  void waitAsync();
+
+  /*!
+   * @brief getScanWindow
+   * Lock-free snapshot of the most recent 360 degree view,
+   * one point per angle bin that has received data.
+   * @param outscan latest points, filtered like CYdLidar::doProcessSimple
+   * @param ages    age of each point at the time of the snapshot [s]
+   * @return false if the rolling window is disabled
+   * @see CYdLidar::setScanWindowBins
+   */
+  bool getScanWindow(LaserScan &outscan, std::vector<float> &ages);
+
+  /*!
+   * @brief processReadable
+   * Parses whatever bytes are pending on the port without blocking.
+   * Only meaningful in threadless mode.
+   * @param scans number of revolutions completed by this call
+   * @return false if the LiDAR is not scanning or the port failed. A LiDAR in
+   * standby returns true and discards what arrived.
+   * @note Waits while CYdLidar::turnOn, CYdLidar::turnOff, CYdLidar::standby,
+   * CYdLidar::resume or CYdLidar::reconfigure talk to the LiDAR on another
+   * thread.
+   * @see CYdLidar::setThreadless
+   */
+  bool processReadable(size_t *scans = NULL);
+
+  /*!
+   * @brief setExternalLoop
+   * Tells whether another thread's event loop currently calls
+   * CYdLidar::processReadable. While true, CYdLidar::grabScan and the other
+   * consumer reads wait for that loop instead of returning at once. Commands
+   * such as CYdLidar::resume and CYdLidar::reconfigure hold the loop off and
+   * read the port from the calling thread until they are done. Only
+   * meaningful in threadless mode.
+   * @param enabled true once the descriptor is watched, false when it no
+   * longer is
+   * @see LidarManager
+   */
+  void setExternalLoop(bool enabled);
+
+  bool getExternalLoop() const;
+
+  /*!
+   * @brief setStallCallback
+   * Called with true as soon as no valid package arrived for
+   * CYdLidar::getDataTimeout, and with false once data flows again.
+   * Runs on the parsing thread, or on the thread calling
+   * CYdLidar::checkWatchdog in threadless mode; it must not block.
+   * @param callback stall callback
+   */
+  void setStallCallback(const YDlidarDriver::StallCallback &callback);
+
+  /*!
+   * @brief getDataTimeout
+   * A few package durations derived from the negotiated sample rate,
+   * DEFAULT_TIMEOUT until the first package arrives.
+   * @return stall timeout [ms]
+   */
+  uint32_t getDataTimeout() const;
+
+  /*!
+   * @brief checkWatchdog
+   * Runs automatically on the parsing thread. In threadless mode, wait at
+   * most CYdLidar::getDataTimeout in your event loop and call this after
+   * every wake-up.
+   * @return true while the data stream is stalled
+   */
+  bool checkWatchdog();
+
+  /*!
+   * @brief getFileDescriptor
+   * @return file descriptor of the LiDAR port, -1 if not connected
+   */
+  int getFileDescriptor();
+
+  /*!
+   * @brief getScanEventFd
+   * Becomes readable when a new scan is ready for CYdLidar::doProcessSimple,
+   * so many LiDARs can be multiplexed in one select/poll/epoll loop.
+   * @return file descriptor, -1 if not connected or unsupported on this platform
+   */
+  int getScanEventFd() const;
+
+  /*!
+   * @brief getSectorEventFd
+   * Becomes readable whenever the rolling window receives a new package.
+   * Cleared by CYdLidar::getScanWindow.
+   * Never becomes readable while the rolling window is disabled.
+   * @return file descriptor, -1 if not connected or unsupported on this platform
+   * @see CYdLidar::setScanWindowBins
+   */
+  int getSectorEventFd() const;
+
+  /*!
+   * @brief addScanConsumer
+   * Registers an independent reader of complete scans.
+   * Every consumer sees every scan, in order, whatever the other consumers
+   * and CYdLidar::doProcessSimple do; the raw nodes are shared between
+   * consumers, not copied.
+   * @param policy   what to drop once the consumer is a full queue behind
+   * @param block_ms with OVERRUN_BLOCK, how long the parser may wait for the
+   * consumer before dropping its oldest scan [ms]
+   * @param depth    scans the consumer may fall behind, 0 for the default of 8;
+   * size it to rate x wake-up period for batch consumers
+   * @return consumer id, -1 if not connected
+   * @see CYdLidar::getScanStats
+   */
+  int addScanConsumer(OverrunPolicy policy = OVERRUN_DROP_OLDEST,
+                      uint32_t block_ms = 0, size_t depth = 0);
+
+  /*!
+   * @brief removeScanConsumer
+   * @param consumer id returned by CYdLidar::addScanConsumer
+   */
+  void removeScanConsumer(int consumer);
+
+  /*!
+   * @brief grabScanFrame
+   * Zero-copy access to the next raw scan of a consumer.
+   * @param consumer id returned by CYdLidar::addScanConsumer
+   * @param frame    shared, read-only scan with its sequence number
+   * @param lost     scans overwritten before this consumer read them
+   * @param timeout  [ms]
+   * @return false on timeout, unknown consumer or once scanning stopped
+   */
+  bool grabScanFrame(int consumer, std::shared_ptr<const ScanFrame> &frame,
+                     uint64_t *lost = NULL,
+                     uint32_t timeout = YDlidarDriver::DEFAULT_TIMEOUT);
+
+  /*!
+   * @brief grabScan
+   * Next scan of a consumer, converted like CYdLidar::doProcessSimple.
+   * @param consumer id returned by CYdLidar::addScanConsumer
+   * @param outscan  LiDAR scan
+   * @param seq      sequence number of the scan, consecutive while nothing is lost
+   * @param lost     scans overwritten before this consumer read them
+   * @param timeout  [ms]
+   * @return false on timeout, unknown consumer or once scanning stopped
+   */
+  bool grabScan(int consumer, LaserScan &outscan, uint64_t *seq = NULL,
+                uint64_t *lost = NULL,
+                uint32_t timeout = YDlidarDriver::DEFAULT_TIMEOUT);
+
+  /*!
+   * @brief grabScanFrames
+   * Zero-copy batch access: every raw scan queued for a consumer since its
+   * last call, taken with one wake-up and one lock acquisition.
+   * @param consumer id returned by CYdLidar::addScanConsumer
+   * @param frames   scans appended oldest first
+   * @param max      maximum number of scans to take
+   * @param lost     scans overwritten before this consumer read them
+   * @param timeout  wait for the first scan [ms]
+   * @return false on timeout, unknown consumer or once scanning stopped
+   */
+  bool grabScanFrames(int consumer,
+                      std::vector<std::shared_ptr<const ScanFrame> > &frames,
+                      size_t max, uint64_t *lost = NULL,
+                      uint32_t timeout = YDlidarDriver::DEFAULT_TIMEOUT);
+
+  /*!
+   * @brief grabScans
+   * Batch form of CYdLidar::grabScan: every scan queued for a consumer since
+   * its last call, converted like CYdLidar::doProcessSimple.
+   * @param consumer id returned by CYdLidar::addScanConsumer
+   * @param scans    resized to the scans taken, oldest first; elements are
+   * reused across calls
+   * @param max      maximum number of scans to take
+   * @param lost     scans overwritten before this consumer read them
+   * @param timeout  wait for the first scan [ms]
+   * @return false on timeout, unknown consumer or once scanning stopped
+   */
+  bool grabScans(int consumer, std::vector<LaserScan> &scans, size_t max,
+                 uint64_t *lost = NULL,
+                 uint32_t timeout = YDlidarDriver::DEFAULT_TIMEOUT);
+
+  /*!
+   * @brief getScanStats
+   * Produced, delivered and overwritten scans of one consumer; produced
+   * always equals delivered + overwritten + pending.
+   * @param consumer id returned by CYdLidar::addScanConsumer,
+   * -1 for the scans of CYdLidar::doProcessSimple since the last turnOn
+   * @param stats    scan accounting
+   * @return false if the consumer is unknown or not connected
+   */
+  bool getScanStats(int consumer, ScanConsumerStats &stats);
+
+  /*!
+   * @brief getNearestScan
+   * @param t time [ns]
+   * @return the history scan whose first point is closest to t,
+   * NULL if the history is empty
+   * @see CYdLidar::setScanHistoryDuration
+   */
+  ScanHistory::ScanPtr getNearestScan(uint64_t t);
+
+  /*!
+   * @brief getScans
+   * @param t0    start time [ns]
+   * @param t1    end time [ns]
+   * @param scans history scans whose first point lies in [t0, t1], oldest first
+   * @see CYdLidar::setScanHistoryDuration
+   */
+  void getScans(uint64_t t0, uint64_t t1,
+                std::vector<ScanHistory::ScanPtr> &scans);
+
+  /*!
+   * @brief getRangeAt
+   * Range at one angle interpolated to time t, e.g. a camera frame time.
+   * @param angle angle [rad], same frame as LaserPoint::angle
+   * @param t     time [ns]
+   * @param range range [m]
+   * @return false if t is not covered by the history or the readings are invalid
+   * @see CYdLidar::setScanHistoryDuration
+   */
+  bool getRangeAt(float angle, uint64_t t, float &range);
+
   //get zero angle offset value
   float getAngleOffset() const;
 
@@ -636,19 +1081,73 @@ class YDLIDAR_API CYdLidar {
    */
   void checkCalibrationAngle(const std::string &serialNumber);
 
+  /// Host-side filter, replaced as a whole and never modified in place.
+  struct ScanFilter {
+    float min_range;            ///< [m]
+    float max_range;            ///< [m]
+    float min_angle;            ///< [°]
+    float max_angle;            ///< [°]
+    std::vector<float> ignore;  ///< ignored sectors, pairs of [°]
+    uint32_t generation;
+  };
+
+  /*!
+   * @brief the filter the next scan is built with
+   */
+  std::shared_ptr<const ScanFilter> currentFilter() const;
+
+  /*!
+   * @brief updateFilter
+   * Publishes the filter properties as a new filter.
+   * @param force also when they did not change
+   */
+  void updateFilter(bool force);
+
   /*!
     * @brief isRangeValid
+    * @param filter
     * @param reading
     * @return
     */
-  bool isRangeValid(double reading) const;
+  bool isRangeValid(const ScanFilter &filter, double reading) const;
 
   /*!
    * @brief isRangeIgnore
+   * @param filter
    * @param angle
    * @return
    */
-  bool isRangeIgnore(double angle) const;
+  bool isRangeIgnore(const ScanFilter &filter, double angle) const;
+
+  /*!
+   * @brief convert the user scan seam angle to the LiDAR raw angle
+   * @return LiDAR raw angle, negative if the scan seam is disabled
+   */
+  float lidarScanSeamAngle() const;
+
+  /*!
+   * @brief convert a LiDAR node to a user frame point
+   * @param node
+   * @param filter
+   * @param point
+   */
+  void nodeToPoint(const node_info &node, const ScanFilter &filter,
+                   LaserPoint &point) const;
+
+  /*!
+   * @brief convert one revolution to a LaserScan
+   * @param nodes          raw nodes
+   * @param count          number of nodes
+   * @param tim_scan_start time of the first node [ns]
+   * @param outscan        LiDAR scan
+   */
+  void fillScan(const node_info *nodes, size_t count, uint64_t tim_scan_start,
+                LaserScan &outscan) const;
+
+  /*!
+   * @brief convert one broadcast frame to a LaserScan
+   */
+  void frameToScan(const ScanFrame &frame, LaserScan &outscan) const;
 
   /*!
    * @brief handleSingleChannelDevice
@@ -660,7 +1159,7 @@ class YDLIDAR_API CYdLidar {
    * @param node
    * @param info
    */
-  void parsePackageNode(const node_info &node, LaserDebug &info);
+  static void parsePackageNode(const node_info &node, LaserDebug &info);
 
   /**
    * @brief handleDeviceInfoPackage
@@ -668,12 +1167,107 @@ class YDLIDAR_API CYdLidar {
    */
   void handleDeviceInfoPackage(int count);
 
+  /**
+   * @brief parseStreamDeviceInfo
+   * Decodes the device information some models interleave with scan data.
+   * @param nodes one scan
+   * @param count number of nodes
+   * @param info  decoded device information
+   * @param serial_number decoded serial number
+   * @return false if this scan does not carry it
+   */
+  static bool parseStreamDeviceInfo(const node_info *nodes, int count,
+                                    device_info &info,
+                                    std::string &serial_number);
+
+  /**
+   * @brief revalidateProfile
+   * After the driver reconnected, checks the scans against the state
+   * negotiated at startup, from the stream alone: the serial number where the
+   * model reports it in-stream, and the number of points per revolution.
+   * @param count number of nodes in global_nodes
+   * @return false once the device no longer matches the cached state
+   */
+  bool revalidateProfile(int count);
+
   /**
    * @brief printfVersionInfo
    * @param info
    */
   void printfVersionInfo(const device_info &info);
 
+  /**
+   * @brief loadProfile
+   * Looks the cached profile of the connected device up, and applies it.
+   * @return false if there is none for the current settings
+   */
+  bool loadProfile();
+
+  /**
+   * @brief saveProfile
+   * Caches the state negotiated by the last full initialize and turnOn.
+   */
+  void saveProfile();
+
+  /**
+   * @brief dropProfile
+   * Deletes the cached profile the last turnOn trusted.
+   */
+  void dropProfile();
+
+  /**
+   * @brief resolvePort
+   * Finds the port of the LiDAR with DeviceSerialNumber.
+   * @return false if no port holds it
+   */
+  bool resolvePort();
+
+  /**
+   * @brief probeSerialNumber
+   * Connects to a port and reads the serial number of the LiDAR on it.
+   * @param port     port to probe
+   * @param baudrate baudrate
+   * @param single_channel single channel LiDARs have to scan until the
+   * serial number shows up in-stream
+   * @param cancel   set once another probe found the LiDAR
+   * @return serial number, "" if none was read
+   */
+  static std::string probeSerialNumber(const std::string &port, int baudrate,
+                                       bool single_channel,
+                                       const std::atomic<bool> &cancel);
+
+  /**
+   * @brief saveIdentity
+   * Remembers the physical port the connected LiDAR was found on.
+   */
+  void saveIdentity();
+
+  /**
+   * @brief checkIdentity
+   * @return false once the connected LiDAR turns out not to be
+   * DeviceSerialNumber
+   */
+  bool checkIdentity() const;
+
+  /**
+   * @brief dropIdentity
+   * Forgets the port remembered for DeviceSerialNumber, it holds another
+   * LiDAR.
+   */
+  void dropIdentity();
+
+  /**
+   * @brief reportProgress
+   * @param stage current bring-up stage
+   */
+  void reportProgress(BringUpStage stage);
+
+  /**
+   * @brief leaveStandby
+   * Disables the low-power mode standby enabled.
+   */
+  void leaveStandby();
+
  private:
   bool    isScanning;
   int     m_FixedSize ;
@@ -687,6 +1281,26 @@ class YDLIDAR_API CYdLidar {
   uint64_t m_PointTime;
   uint64_t last_node_time;
   node_info *global_nodes;
+  ScanHistory m_history;
+  YDlidarDriver::StallCallback m_stallCallback;
+  uint32_t m_reconnectCount;      ///< driver reconnects already revalidated
+  int m_revalidateScans;          ///< scans left to check after a reconnect
+  int m_revalidateFailures;       ///< mismatching scans since the reconnect
+  float m_scanPoints;             ///< average points per revolution
+  float m_UserScanFrequency;      ///< scan frequency before negotiation
+  bool m_profileLoaded;           ///< initialize applied a cached profile
+  bool m_profileTrusted;          ///< scanning on a not yet validated profile
+  std::atomic<bool> m_standby;    ///< parked by standby, until scanning restarts
+  std::atomic<bool> m_ExternalLoop;  ///< another thread's loop reads the port
+  bool m_lowPower;                ///< standby enabled the low-power mode
+  std::atomic<bool> m_reconfiguring;  ///< LiDAR commands of reconfigure
+  mutable Locker m_filterLock;
+  Locker m_ioLock;                ///< port access, event loop vs. commands
+  std::shared_ptr<const ScanFilter> m_filter;
+  std::string m_profileFile;      ///< the cached profile initialize applied
+  std::string m_claimedPort;      ///< port registered as in use by this instance
+  ProgressCallback m_progressCallback;
+  std::shared_future<bool> m_bringUp; ///< last asynchronous call
   std::map<int, int> SampleRateMap;
   bool m_ParseSuccess;
   std::string m_lidarSoftVer;
@@ -0,0 +1,124 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "v8stdint.h"
+#include <string>
+
+namespace ydlidar {
+
+/*!
+ * @brief Byte stream the driver decodes LiDAR data from.
+ * @note ::create picks the implementation from the port name:
+ * <table>
+ *   <tr><th>Port                      <th>Channel
+ *   <tr><td>/dev/ttyUSB0, COM3         <td>serial port
+ *   <tr><td>tcp://host:port            <td>TCP client, e.g. a serial-over-Ethernet bridge
+ *   <tr><td>udp://host:port            <td>UDP, datagrams to and from host
+ *   <tr><td>udp://:port                <td>UDP, datagrams from anyone to the local port,
+ *                                          replies to the last sender
+ *   <tr><td>unix:///path               <td>Unix domain stream socket, e.g. a simulator
+ *   <tr><td>pipe:///path               <td>named pipe fed by another process, writes are discarded
+ *   <tr><td>file:///path[?options]     <td>replay of a recorded stream at the baudrate,
+ *                                          played from the start by a scan command
+ *                                          and paused by a stop command
+ * </table>
+ * Replay options, joined by '&': loop starts over at the end of the file,
+ * fast replays as fast as the reader consumes, e.g. for benchmarks.
+ * Only the serial port exists on Windows. DTR only means something on a
+ * serial port, the others ignore it.
+ */
+class ChannelDevice {
+ public:
+  virtual ~ChannelDevice() {}
+
+  /*!
+   * @brief create the channel for a port name, not opened yet
+   * @param[in] port      port name or URI
+   * @param[in] baudrate  baudrate of the LiDAR's serial line
+   * @param[in] timeout   read timeout(ms)
+   * @return NULL if the scheme is not supported here
+   */
+  static ChannelDevice *create(const std::string &port, uint32_t baudrate,
+                               uint32_t timeout);
+
+  //! whether the port name is a URI rather than a device
+  static bool isUri(const std::string &port) {
+    return port.find("://") != std::string::npos;
+  }
+
+  virtual bool open() = 0;
+
+  virtual bool isOpen() = 0;
+
+  virtual void closePort() = 0;
+
+  //! wait until pending writes went out
+  virtual void flush() {}
+
+  //! bytes readable without blocking
+  virtual size_t available() = 0;
+
+  /*!
+   * @brief wait until data_count bytes are readable
+   * @param[in] data_count    bytes to wait for
+   * @param[in] timeout       超时时间(ms)
+   * @param[out] returned_size bytes readable
+   * @return 0 on success, -1 on timeout or wake up, -2 on error or when the
+   * peer closed the stream
+   */
+  virtual int waitfordata(size_t data_count, uint32_t timeout,
+                          size_t *returned_size) = 0;
+
+  //! @return bytes written, 0 on error
+  virtual size_t writeData(const uint8_t *data, size_t size) = 0;
+
+  //! @return bytes read, waits up to the read timeout for the first one, 0 on error
+  virtual size_t readData(uint8_t *data, size_t size) = 0;
+
+  virtual bool setDTR(bool level = true) {
+    (void)level;
+    return false;
+  }
+
+  //! time to transfer one byte on the LiDAR's line [ns], 0 if unknown
+  virtual uint32_t getByteTime() = 0;
+
+  //! descriptor to poll for readability, -1 if there is none
+  virtual int getFileDescriptor() = 0;
+
+  //! readable descriptor that interrupts ::waitfordata
+  virtual void setWakeupDescriptor(int fd) = 0;
+};
+
+}// namespace ydlidar
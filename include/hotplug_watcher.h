@@ -0,0 +1,256 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "v8stdint.h"
+#include "ydlidar_protocol.h"
+#include "timer.h"
+#include <string>
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ydlidar {
+
+/*!
+ * @brief Waits for a serial device node to (re)appear.
+ * @note Watches the directory of the device with inotify, plus /dev when the
+ * device lives in a sub directory such as /dev/serial/by-id, which is removed
+ * together with the last device. Creation, rename and permission changes of
+ * the node all count, since udev fixes permissions after creating it.\n
+ * Linux only; elsewhere ::isSupported is false and callers fall back to
+ * sleeping.
+ */
+class HotplugWatcher {
+ public:
+  HotplugWatcher() : m_fd(-1), m_devWd(-1), m_dirWd(-1) {
+#ifdef __linux__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_fd < 0) {
+      fprintf(stderr, "Failed to create hotplug watcher: %s\n", strerror(errno));
+      fflush(stderr);
+    }
+
+#endif
+  }
+
+  ~HotplugWatcher() {
+#ifdef __linux__
+
+    if (m_fd >= 0) {
+      close(m_fd);
+    }
+
+#endif
+  }
+
+  bool isSupported() const {
+    return m_fd >= 0;
+  }
+
+  /*!
+   * @brief device node to watch \n
+   * Watching starts right away, so a node appearing between
+   * ::isPresent and ::waitForChange is not missed.
+   */
+  void setPath(const std::string &path) {
+    if (path == m_path) {
+      return;
+    }
+
+    m_path = path;
+    size_t pos = path.find_last_of('/');
+
+    if (pos == std::string::npos) {
+      m_dir = ".";
+      m_name = path;
+    } else {
+      m_dir = pos == 0 ? "/" : path.substr(0, pos);
+      m_name = path.substr(pos + 1);
+    }
+
+#ifdef __linux__
+
+    if (m_dirWd >= 0 && m_dirWd != m_devWd) {
+      inotify_rm_watch(m_fd, m_dirWd);
+    }
+
+    m_dirWd = -1;
+#endif
+    arm();
+  }
+
+  bool isPresent() const {
+#ifdef __linux__
+    return !m_path.empty() && access(m_path.c_str(), F_OK) == 0;
+#else
+    return true;
+#endif
+  }
+
+  /*!
+   * @brief wait until the device node changes \n
+   * @param[in] timeout   超时时间(ms)
+   * @param[in] cancel_fd readable descriptor that aborts the wait, may be -1
+   * @return 返回执行结果
+   * @retval RESULT_OK       设备节点出现或变化
+   * @retval RESULT_TIMEOUT  等待超时
+   * @retval RESULT_FAIL     被cancel_fd中断或不支持
+   */
+  result_t waitForChange(uint32_t timeout, int cancel_fd = -1) {
+#ifdef __linux__
+
+    if (m_fd < 0) {
+      return RESULT_FAIL;
+    }
+
+    uint32_t startTs = getms();
+    uint32_t waitTime = 0;
+
+    while ((waitTime = getms() - startTs) < timeout) {
+      arm();
+      pollfd fds[2];
+      fds[0].fd = m_fd;
+      fds[0].events = POLLIN;
+      fds[1].fd = cancel_fd;
+      fds[1].events = POLLIN;
+      int n = poll(fds, cancel_fd >= 0 ? 2 : 1, timeout - waitTime);
+
+      if (n < 0 && errno != EINTR) {
+        return RESULT_FAIL;
+      }
+
+      if (n <= 0) {
+        continue;
+      }
+
+      if (cancel_fd >= 0 && fds[1].revents) {
+        return RESULT_FAIL;
+      }
+
+      if (drain()) {
+        return RESULT_OK;
+      }
+    }
+
+    return RESULT_TIMEOUT;
+#else
+    (void)timeout;
+    (void)cancel_fd;
+    return RESULT_FAIL;
+#endif
+  }
+
+ private:
+  HotplugWatcher(const HotplugWatcher &);
+  HotplugWatcher &operator=(const HotplugWatcher &);
+
+#ifdef __linux__
+  /*!
+   * @brief (re)add the watches, the sub directory comes and goes with its devices
+   */
+  void arm() {
+    const uint32_t mask = IN_CREATE | IN_MOVED_TO | IN_ATTRIB;
+
+    if (m_fd < 0 || m_path.empty()) {
+      return;
+    }
+
+    if (m_devWd < 0) {
+      m_devWd = inotify_add_watch(m_fd, "/dev", mask);
+    }
+
+    if (m_dirWd < 0) {
+      //adding an existing watch again returns the same descriptor.
+      m_dirWd = inotify_add_watch(m_fd, m_dir.c_str(), mask);
+    }
+  }
+
+  /*!
+   * @brief consume pending events
+   * @return true if one concerns the device
+   */
+  bool drain() {
+    char buffer[4096] __attribute__((aligned(__alignof__(inotify_event))));
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = read(m_fd, buffer, sizeof(buffer))) > 0) {
+      for (char *ptr = buffer; ptr < buffer + len;) {
+        const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+
+        if (event->mask & IN_IGNORED) {
+          //the sub directory went away with the device.
+          if (event->wd == m_dirWd) {
+            m_dirWd = -1;
+          }
+
+          if (event->wd == m_devWd) {
+            m_devWd = -1;
+          }
+
+          continue;
+        }
+
+        if (event->wd == m_dirWd && event->len > 0 && m_name == event->name) {
+          changed = true;
+        }
+      }
+    }
+
+    //an event in /dev may have recreated the sub directory with the node.
+    if (m_dirWd < 0) {
+      arm();
+      changed = changed || isPresent();
+    }
+
+    return changed;
+  }
+#endif
+
+  int m_fd;             ///< inotify描述符
+  int m_devWd;          ///< /dev监视
+  int m_dirWd;          ///< 设备所在目录监视
+  std::string m_path;   ///< 设备节点
+  std::string m_dir;    ///< 设备所在目录
+  std::string m_name;   ///< 设备节点名
+};
+
+}// namespace ydlidar
@@ -0,0 +1,170 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "lidar_profile.h"
+#include "serial.h"
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ydlidar {
+
+/*!
+ * @brief Where a LiDAR was last found, by serial number, cached on disk.
+ * @note One "key=value" text file per serial number, next to the profiles.
+ * Device names like /dev/ttyUSB0 change between boots, the physical USB port
+ * of the adapter does not.
+ */
+struct LidarIdentity {
+  enum {
+    VERSION = 1,
+  };
+
+  std::string serial;       ///< LiDAR serial number, the cache key
+  std::string usb_path;     ///< physical USB port of the adapter
+  std::string usb_serial;   ///< USB serial number of the adapter, may be empty
+  std::string port;         ///< device name it was last found on
+
+  static std::string fileName(const std::string &dir, const std::string &key) {
+    return LidarProfile::fileName(dir, key, ".identity");
+  }
+
+  /*!
+   * @brief 当前端口中的对应端口
+   * @note 优先按USB物理端口匹配; 适配器换了USB口时, 按唯一的适配器序列号匹配
+   * @return 端口序号, 找不到返回-1
+   */
+  int locate(const std::vector<serial::PortInfo> &ports) const {
+    int found = -1;
+
+    for (size_t i = 0; i < ports.size(); i++) {
+      if (!usb_path.empty() && ports[i].usb_path == usb_path) {
+        return static_cast<int>(i);
+      }
+    }
+
+    //cheap adapters share one serial number, only a unique one identifies.
+    for (size_t i = 0; i < ports.size() && !usb_serial.empty(); i++) {
+      if (ports[i].serial_number == usb_serial) {
+        if (found >= 0) {
+          return -1;
+        }
+
+        found = static_cast<int>(i);
+      }
+    }
+
+    return found;
+  }
+
+  bool operator==(const LidarIdentity &other) const {
+    return serial == other.serial && usb_path == other.usb_path &&
+           usb_serial == other.usb_serial && port == other.port;
+  }
+
+  bool load(const std::string &file) {
+    FILE *fp = fopen(file.c_str(), "r");
+
+    if (!fp) {
+      return false;
+    }
+
+    std::map<std::string, std::string> values;
+    char line[256];
+
+    while (fgets(line, sizeof(line), fp)) {
+      std::string text(line);
+      size_t pos = text.find('=');
+
+      if (pos == std::string::npos) {
+        continue;
+      }
+
+      size_t end = text.find_last_not_of("\r\n");
+      values[text.substr(0, pos)] = end > pos ? text.substr(pos + 1,
+                                    end - pos) : "";
+    }
+
+    fclose(fp);
+
+    if (atoi(values["version"].c_str()) != VERSION ||
+        values["serial"].empty()) {
+      return false;
+    }
+
+    serial = values["serial"];
+    usb_path = values["usb_path"];
+    usb_serial = values["usb_serial"];
+    port = values["port"];
+    return !usb_path.empty() || !usb_serial.empty();
+  }
+
+  /*!
+   * @brief 先写临时文件再改名, 中断的写入不会留下半个文件
+   */
+  bool save(const std::string &file) const {
+    std::string temp = file + ".tmp";
+    FILE *fp = fopen(temp.c_str(), "w");
+
+    if (!fp) {
+      return false;
+    }
+
+    fprintf(fp, "version=%d\n", VERSION);
+    fprintf(fp, "serial=%s\n", serial.c_str());
+    fprintf(fp, "usb_path=%s\n", usb_path.c_str());
+    fprintf(fp, "usb_serial=%s\n", usb_serial.c_str());
+    fprintf(fp, "port=%s\n", port.c_str());
+
+    if (fclose(fp) != 0) {
+      remove(temp.c_str());
+      return false;
+    }
+
+#ifdef _WIN32
+    //rename does not replace an existing file here.
+    remove(file.c_str());
+#endif
+
+    if (rename(temp.c_str(), file.c_str()) != 0) {
+      remove(temp.c_str());
+      return false;
+    }
+
+    return true;
+  }
+};
+
+}// namespace ydlidar
@@ -0,0 +1,153 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "CYdLidar.h"
+#include <functional>
+#include <future>
+#include <vector>
+
+/**
+ * @brief Serves many LiDARs from a small, fixed pool of threads.
+ * Every device is switched to threadless mode and its port is multiplexed with
+ * epoll, so CPU usage follows the data rate rather than the number of devices.
+ * Devices are sharded over the workers round-robin by id.\n
+ * Workers also drive each device's watchdog, so a stall callback set with
+ * CYdLidar::setStallCallback fires within its CYdLidar::getDataTimeout.\n
+ * LidarManager does not reconnect. A device whose port hangs up or fails to
+ * read leaves the loop for good and reports START_FAILED; LidarManager::stop
+ * followed by LidarManager::start brings every device up again.
+ * @note Linux only; LidarManager::start fails on other platforms.
+ */
+class YDLIDAR_API LidarManager {
+ public:
+  /// Called from a worker thread with the latest scan of every readable
+  /// event. Scans completed by the same read replace each other; the
+  /// replaced ones count as overwritten in CYdLidar::getScanStats(-1). Use a
+  /// CYdLidar::addScanConsumer consumer to see every scan.
+  typedef std::function<void(int id, const LaserScan &scan)> ScanCallback;
+  /// Called from a worker thread when a device fails and leaves the loop for
+  /// good.
+  typedef std::function<void(int id)> ErrorCallback;
+
+  /// Outcome of bringing one LiDAR up.
+  enum StartResult {
+    START_OK = 0,     ///< initialized and scanning
+    START_FAILED,     ///< initialize or turnOn failed, or stopped responding;
+                      ///< not retried until the next LidarManager::start
+    START_TIMEOUT,    ///< still bringing up at the deadline
+  };
+
+  /*!
+   * @brief startAll
+   * Initializes and turns on every LiDAR concurrently, so the whole set takes
+   * about as long as its slowest device.
+   * @param lidars  configured, not yet initialized LiDARs
+   * @param timeout aggregate deadline [ms], 0: wait for every device
+   * @param results one result per LiDAR
+   * @return number of LiDARs scanning
+   * @note A device that timed out keeps bringing itself up in the background;
+   * its destructor waits for it.
+   * @see CYdLidar::initializeAsync and CYdLidar::turnOnAsync
+   */
+  static size_t startAll(const std::vector<CYdLidar *> &lidars,
+                         uint32_t timeout, std::vector<StartResult> &results);
+
+  /*!
+   * @param workers number of event-loop threads, at least one
+   */
+  explicit LidarManager(int workers = 1);
+  virtual ~LidarManager();
+
+  /*!
+   * @brief addLidar
+   * Takes ownership of a configured, not yet initialized LiDAR.
+   * @return device id, -1 if the manager is running
+   */
+  int addLidar(CYdLidar *lidar);
+
+  //! get a managed LiDAR, NULL if the id is unknown
+  CYdLidar *getLidar(int id) const;
+
+  //! number of managed LiDARs
+  size_t getLidarCount() const;
+
+  void setScanCallback(const ScanCallback &callback);
+
+  void setErrorCallback(const ErrorCallback &callback);
+
+  /*!
+   * @brief setStartTimeout
+   * @param timeout deadline for LidarManager::start to bring every LiDAR up
+   * [ms], 0(default) waits for every device
+   */
+  void setStartTimeout(uint32_t timeout);
+
+  /*!
+   * @brief start
+   * Initializes and turns on every LiDAR concurrently, then starts the
+   * workers with those that came up.
+   * @return false if any LiDAR failed or timed out; the others keep running
+   * @see LidarManager::startAll and LidarManager::getStartResult
+   */
+  bool start();
+
+  //! result of the last LidarManager::start for a LiDAR
+  StartResult getStartResult(int id) const;
+
+  //! stops the workers, then turns every LiDAR off and disconnects it
+  void stop();
+
+  bool isRunning() const;
+
+ protected:
+  struct Worker;
+
+  static _size_t THREAD_PROC workerProc(void *param);
+
+  int runWorker(Worker *worker);
+
+  void handleReadable(Worker *worker, int id, uint32_t events);
+
+ private:
+  LidarManager(const LidarManager &);
+  LidarManager &operator=(const LidarManager &);
+
+  std::vector<CYdLidar *> m_lidars;
+  std::vector<Worker *>   m_workers;
+  std::vector<StartResult> m_results;
+  uint32_t                m_startTimeout;
+  ScanCallback            m_scanCallback;
+  ErrorCallback           m_errorCallback;
+  std::atomic<bool>       m_running;
+};
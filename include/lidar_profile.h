@@ -0,0 +1,208 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "v8stdint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <map>
+#include <string>
+
+namespace ydlidar {
+
+/*!
+ * @brief What CYdLidar negotiated with one device, cached on disk.
+ * @note One "key=value" text file per serial number. A profile only applies
+ * to the settings it was negotiated for, see LidarProfile::matches.
+ */
+struct LidarProfile {
+  enum {
+    VERSION = 1,
+  };
+
+  std::string serial;             ///< serial number, the cache key
+  int model;
+  int lidar_type;
+  bool single_channel;
+  bool intensities;
+  int major;
+  int minor;
+  int hardware;
+  int requested_sample_rate;      ///< sample rate asked for [K]
+  float requested_frequency;      ///< scan frequency asked for [Hz]
+  int sample_rate;                ///< negotiated sample rate [K]
+  int default_sample_rate;
+  float scan_frequency;           ///< negotiated scan frequency [Hz]
+  int fixed_size;                 ///< points per revolution
+  uint64_t point_time;            ///< [ns]
+  float angle_offset;             ///< zero offset angle [°]
+  bool angle_offset_corrected;
+
+  LidarProfile() : model(0), lidar_type(0), single_channel(false),
+    intensities(false), major(0), minor(0), hardware(0),
+    requested_sample_rate(0), requested_frequency(0.f), sample_rate(0),
+    default_sample_rate(0), scan_frequency(0.f), fixed_size(0),
+    point_time(0), angle_offset(0.f), angle_offset_corrected(false) {
+  }
+
+  /*!
+   * @brief 缓存目录下序列号对应的文件
+   */
+  static std::string fileName(const std::string &dir, const std::string &key,
+                              const char *ext = ".profile") {
+    std::string file = dir;
+
+    if (!file.empty() && file[file.size() - 1] != '/' &&
+        file[file.size() - 1] != '\\') {
+      file += '/';
+    }
+
+    //port names contain separators.
+    for (size_t i = 0; i < key.size(); i++) {
+      char c = key[i];
+      file += (c == '/' || c == '\\' || c == ':') ? '_' : c;
+    }
+
+    return file + ext;
+  }
+
+  /*!
+   * @brief 是否为同样的请求参数协商所得
+   */
+  bool matches(int sample_rate_, float frequency_, bool single_channel_) const {
+    return !serial.empty() && requested_sample_rate == sample_rate_ &&
+           fabsf(requested_frequency - frequency_) < 0.01f &&
+           single_channel == single_channel_;
+  }
+
+  bool load(const std::string &file) {
+    FILE *fp = fopen(file.c_str(), "r");
+
+    if (!fp) {
+      return false;
+    }
+
+    std::map<std::string, std::string> values;
+    char line[256];
+
+    while (fgets(line, sizeof(line), fp)) {
+      std::string text(line);
+      size_t pos = text.find('=');
+
+      if (pos == std::string::npos) {
+        continue;
+      }
+
+      size_t end = text.find_last_not_of("\r\n");
+      values[text.substr(0, pos)] = end > pos ? text.substr(pos + 1,
+                                    end - pos) : "";
+    }
+
+    fclose(fp);
+
+    if (atoi(values["version"].c_str()) != VERSION ||
+        values["serial"].empty()) {
+      return false;
+    }
+
+    serial = values["serial"];
+    model = atoi(values["model"].c_str());
+    lidar_type = atoi(values["lidar_type"].c_str());
+    single_channel = atoi(values["single_channel"].c_str()) != 0;
+    intensities = atoi(values["intensities"].c_str()) != 0;
+    major = atoi(values["major"].c_str());
+    minor = atoi(values["minor"].c_str());
+    hardware = atoi(values["hardware"].c_str());
+    requested_sample_rate = atoi(values["requested_sample_rate"].c_str());
+    requested_frequency = atof(values["requested_frequency"].c_str());
+    sample_rate = atoi(values["sample_rate"].c_str());
+    default_sample_rate = atoi(values["default_sample_rate"].c_str());
+    scan_frequency = atof(values["scan_frequency"].c_str());
+    fixed_size = atoi(values["fixed_size"].c_str());
+    point_time = strtoull(values["point_time"].c_str(), NULL, 10);
+    angle_offset = atof(values["angle_offset"].c_str());
+    angle_offset_corrected = atoi(values["angle_offset_corrected"].c_str()) != 0;
+    return sample_rate > 0 && fixed_size > 0 && point_time > 0;
+  }
+
+  /*!
+   * @brief 先写临时文件再改名, 中断的写入不会留下半个文件
+   */
+  bool save(const std::string &file) const {
+    std::string temp = file + ".tmp";
+    FILE *fp = fopen(temp.c_str(), "w");
+
+    if (!fp) {
+      return false;
+    }
+
+    fprintf(fp, "version=%d\n", VERSION);
+    fprintf(fp, "serial=%s\n", serial.c_str());
+    fprintf(fp, "model=%d\n", model);
+    fprintf(fp, "lidar_type=%d\n", lidar_type);
+    fprintf(fp, "single_channel=%d\n", single_channel ? 1 : 0);
+    fprintf(fp, "intensities=%d\n", intensities ? 1 : 0);
+    fprintf(fp, "major=%d\n", major);
+    fprintf(fp, "minor=%d\n", minor);
+    fprintf(fp, "hardware=%d\n", hardware);
+    fprintf(fp, "requested_sample_rate=%d\n", requested_sample_rate);
+    fprintf(fp, "requested_frequency=%f\n", requested_frequency);
+    fprintf(fp, "sample_rate=%d\n", sample_rate);
+    fprintf(fp, "default_sample_rate=%d\n", default_sample_rate);
+    fprintf(fp, "scan_frequency=%f\n", scan_frequency);
+    fprintf(fp, "fixed_size=%d\n", fixed_size);
+    fprintf(fp, "point_time=%llu\n", (unsigned long long)point_time);
+    fprintf(fp, "angle_offset=%f\n", angle_offset);
+    fprintf(fp, "angle_offset_corrected=%d\n", angle_offset_corrected ? 1 : 0);
+
+    if (fclose(fp) != 0) {
+      remove(temp.c_str());
+      return false;
+    }
+
+#ifdef _WIN32
+    //rename does not replace an existing file here.
+    remove(file.c_str());
+#endif
+
+    if (rename(temp.c_str(), file.c_str()) != 0) {
+      remove(temp.c_str());
+      return false;
+    }
+
+    return true;
+  }
+};
+
+}// namespace ydlidar
@@ -14,6 +14,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 #endif
 
 
@@ -335,6 +343,102 @@ _final:
 #endif
 };
 
+/**
+ * Event that can be multiplexed with select/poll/epoll.
+ * The descriptor becomes readable on set() and stays readable until clear().
+ * Backed by an eventfd on Linux and a non-blocking pipe on other unix systems.
+ * Not available on Windows, where fd() returns -1.
+ */
+class PollEvent {
+ public:
+  PollEvent() {
+    _fd[0] = -1;
+    _fd[1] = -1;
+#ifndef _WIN32
+#ifdef __linux__
+    _fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _fd[1] = _fd[0];
+#else
+
+    if (pipe(_fd) == 0) {
+      for (int i = 0; i < 2; i++) {
+        fcntl(_fd[i], F_SETFL, fcntl(_fd[i], F_GETFL) | O_NONBLOCK);
+        fcntl(_fd[i], F_SETFD, FD_CLOEXEC);
+      }
+    } else {
+      _fd[0] = -1;
+      _fd[1] = -1;
+    }
+
+#endif
+
+    if (_fd[0] < 0) {
+      fprintf(stderr, "Failed to create poll event: %s\n", strerror(errno));
+      fflush(stderr);
+    }
+
+#endif
+  }
+
+  ~PollEvent() {
+#ifndef _WIN32
+
+    if (_fd[1] >= 0 && _fd[1] != _fd[0]) {
+      close(_fd[1]);
+    }
+
+    if (_fd[0] >= 0) {
+      close(_fd[0]);
+    }
+
+#endif
+  }
+
+  /** readable end, -1 if unsupported */
+  int fd() const {
+    return _fd[0];
+  }
+
+  void set() {
+#ifndef _WIN32
+
+    if (_fd[1] < 0) {
+      return;
+    }
+
+#ifdef __linux__
+    uint64_t value = 1;
+#else
+    uint8_t value = 1;
+#endif
+    //a full counter or pipe already reads as signalled.
+    ssize_t ret = write(_fd[1], &value, sizeof(value));
+    (void)ret;
+#endif
+  }
+
+  void clear() {
+#ifndef _WIN32
+
+    if (_fd[0] < 0) {
+      return;
+    }
+
+    uint8_t buffer[64];
+
+    while (read(_fd[0], buffer, sizeof(buffer)) > 0) {
+    }
+
+#endif
+  }
+
+ private:
+  PollEvent(const PollEvent &);
+  PollEvent &operator=(const PollEvent &);
+
+  int _fd[2];
+};
+
 class ScopedLocker {
  public :
   explicit ScopedLocker(Locker &l): _binded(l) {
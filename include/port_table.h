@@ -0,0 +1,173 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "serial.h"
+#include "locker.h"
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ydlidar {
+
+/*!
+ * @brief Cached table of the LiDAR serial ports.
+ * @note The ports are enumerated on the first query, and again only after a
+ * ttyUSB or ttyACM node was added to or removed from /dev, which inotify
+ * reports without polling. A query is then a few syscalls.\n
+ * Where inotify is not available every query enumerates again.
+ */
+class PortTable {
+ public:
+  PortTable() : m_fd(-1), m_valid(false) {
+#ifdef __linux__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    //watch before the first enumeration, so no change is missed.
+    if (m_fd >= 0 && inotify_add_watch(m_fd, "/dev", IN_CREATE | IN_DELETE |
+                                       IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+      close(m_fd);
+      m_fd = -1;
+    }
+
+    if (m_fd < 0) {
+      fprintf(stderr, "Failed to watch serial ports: %s\n", strerror(errno));
+      fflush(stderr);
+    }
+
+#endif
+  }
+
+  ~PortTable() {
+#ifdef __linux__
+
+    if (m_fd >= 0) {
+      close(m_fd);
+    }
+
+#endif
+  }
+
+  /*!
+   * @brief USB serial adapters to look for \n
+   * @param vid_pids VID:PID as lower case hex, e.g. "10c4:ea60", the known
+   * LiDAR adapters if empty
+   */
+  void setAdapters(const std::vector<std::string> &vid_pids) {
+    ScopedLocker l(m_lock);
+    m_vidPids = vid_pids;
+    m_valid = false;
+  }
+
+  /*!
+   * @brief ports of the adapters
+   * @param serial_number USB serial number, any if empty
+   */
+  std::vector<serial::PortInfo> ports(const std::string &serial_number =
+                                        std::string()) {
+    ScopedLocker l(m_lock);
+
+    if (drain() || !m_valid) {
+      m_ports = m_vidPids.empty() ? serial::list_ports() :
+                serial::list_ports(m_vidPids);
+      m_valid = m_fd >= 0;
+    }
+
+    if (serial_number.empty()) {
+      return m_ports;
+    }
+
+    std::vector<serial::PortInfo> found;
+
+    for (size_t i = 0; i < m_ports.size(); i++) {
+      if (m_ports[i].serial_number == serial_number) {
+        found.push_back(m_ports[i]);
+      }
+    }
+
+    return found;
+  }
+
+  //! enumerate again on the next query
+  void invalidate() {
+    ScopedLocker l(m_lock);
+    m_valid = false;
+  }
+
+ private:
+  PortTable(const PortTable &);
+  PortTable &operator=(const PortTable &);
+
+  /*!
+   * @brief consume pending events
+   * @return true if a USB serial node came or went
+   */
+  bool drain() {
+    bool changed = false;
+#ifdef __linux__
+    char buffer[4096] __attribute__((aligned(__alignof__(inotify_event))));
+    ssize_t len;
+
+    while (m_fd >= 0 && (len = read(m_fd, buffer, sizeof(buffer))) > 0) {
+      for (char *ptr = buffer; ptr < buffer + len;) {
+        const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+          changed = true;
+        } else if (event->len > 0 &&
+                   (strncmp(event->name, "ttyUSB", 6) == 0 ||
+                    strncmp(event->name, "ttyACM", 6) == 0)) {
+          changed = true;
+        }
+      }
+    }
+
+#endif
+    return changed;
+  }
+
+  int m_fd;                                ///< inotify描述符
+  bool m_valid;                            ///< 缓存有效
+  Locker m_lock;                           ///< 缓存锁
+  std::vector<std::string> m_vidPids;      ///< 适配器VID:PID
+  std::vector<serial::PortInfo> m_ports;   ///< 缓存的端口
+};
+
+}// namespace ydlidar
@@ -0,0 +1,453 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "v8stdint.h"
+#include "ydlidar_protocol.h"
+#include "locker.h"
+#include "timer.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace ydlidar {
+
+/*!
+ * @brief one published revolution, shared read-only by every consumer
+ */
+struct ScanFrame {
+  uint64_t               seq;    ///< 发布序号, 从1开始连续递增
+  uint64_t               stamp;  ///< 发布时刻(ns), 点的时刻 = stamp - node.stamp
+  std::vector<node_info> nodes;  ///< 一圈激光点
+};
+
+/*!
+ * @brief what to do when a consumer's queue is full
+ */
+enum OverrunPolicy {
+  OVERRUN_DROP_OLDEST = 0,  ///< 丢弃最旧一圈, 保留最新数据
+  OVERRUN_DROP_NEWEST,      ///< 丢弃新到一圈, 保留已排队数据
+  OVERRUN_BLOCK,            ///< 阻塞发布直到有空位, 超时后丢弃最旧一圈
+};
+
+/*!
+ * @brief scan accounting of one consumer \n
+ * produced = delivered + overwritten + pending
+ */
+struct ScanConsumerStats {
+  uint64_t produced;     ///< 注册后发布的圈数
+  uint64_t delivered;    ///< 已读取的圈数
+  uint64_t overwritten;  ///< 未读取即被丢弃的圈数
+  uint64_t pending;      ///< 排队待读取的圈数
+};
+
+/*!
+ * @brief Single producer, multi consumer broadcast of the latest revolutions.
+ * @note Every consumer owns a bounded queue and its own wake-up event, so
+ * readers never take frames away from each other.\n
+ * Frames are handed out as shared pointers and never copied; the producer
+ * refills a frame in place once no consumer holds it any more.\n
+ * A consumer whose queue is full loses one frame according to its
+ * ::OverrunPolicy, and is told how many frames it lost.
+ */
+class ScanBroadcast {
+ public:
+  explicit ScanBroadcast(size_t depth = 8)
+    : m_depth(depth > 0 ? depth : 1), m_head(0), m_consumers(0),
+      m_closed(false) {
+    m_pool.resize(m_depth + 1);
+  }
+
+  ~ScanBroadcast() {
+    for (size_t i = 0; i < m_readers.size(); i++) {
+      delete m_readers[i];
+    }
+
+    for (size_t i = 0; i < m_retired.size(); i++) {
+      delete m_retired[i];
+    }
+  }
+
+  size_t depth() const {
+    return m_depth;
+  }
+
+  /*!
+   * @brief number of registered consumers \n
+   * The producer skips publishing while it is zero.
+   */
+  int consumerCount() const {
+    return m_consumers;
+  }
+
+  /*!
+   * @brief register a consumer \n
+   * @param[in] policy   队列满时的处理策略
+   * @param[in] block_ms OVERRUN_BLOCK时发布最长阻塞时间(ms)
+   * @param[in] depth    最多排队的圈数, 0: ::depth
+   * @return consumer id, it receives frames published from now on
+   */
+  int addConsumer(OverrunPolicy policy = OVERRUN_DROP_OLDEST,
+                  uint32_t block_ms = 0, size_t depth = 0) {
+    ScopedLocker l(m_lock);
+    Reader *reader = new Reader();
+    reader->policy = policy;
+    reader->block_ms = block_ms;
+    reader->depth = depth > 0 ? depth : m_depth;
+
+    if (m_pool.size() < reader->depth + 1) {
+      m_pool.resize(reader->depth + 1);
+    }
+
+    reader->last_seq = m_head;
+    reader->produced = 0;
+    reader->delivered = 0;
+    reader->overwritten = 0;
+
+    for (size_t i = 0; i < m_readers.size(); i++) {
+      if (!m_readers[i]) {
+        m_readers[i] = reader;
+        m_consumers++;
+        return static_cast<int>(i);
+      }
+    }
+
+    m_readers.push_back(reader);
+    m_consumers++;
+    return static_cast<int>(m_readers.size() - 1);
+  }
+
+  void removeConsumer(int id) {
+    ScopedLocker l(m_lock);
+
+    if (id < 0 || id >= static_cast<int>(m_readers.size()) || !m_readers[id]) {
+      return;
+    }
+
+    //a reader blocked in ::next, or a producer blocked on its queue, is
+    //woken up and sees the id is gone.
+    Reader *reader = m_readers[id];
+    m_readers[id] = NULL;
+    m_consumers--;
+    reader->queue.clear();
+    m_retired.push_back(reader);
+    reader->event.set();
+    reader->space.set();
+  }
+
+  /*!
+   * @brief publish one revolution \n
+   * @param[in] nodes 激光点信息
+   * @param[in] count 激光点数
+   * @param[in] stamp 发布时刻(ns)
+   * @return sequence number of the new frame
+   * @note must only be called from a single producer thread,
+   * blocks only for consumers registered with OVERRUN_BLOCK
+   */
+  uint64_t publish(const node_info *nodes, size_t count, uint64_t stamp) {
+    std::shared_ptr<ScanFrame> frame;
+    uint64_t seq = m_head + 1;
+    {
+      ScopedLocker l(m_lock);
+      //queues hold at most the deepest queue's frames, so a pool one larger
+      //always has a free frame once the slowest consumer drops its reference.
+      frame.swap(m_pool[seq % m_pool.size()]);
+    }
+
+    if (!frame || !frame.unique()) {
+      frame = std::make_shared<ScanFrame>();
+    }
+
+    frame->seq = seq;
+    frame->stamp = stamp;
+    frame->nodes.assign(nodes, nodes + count);
+
+    std::vector<Reader *> blocked;
+    {
+      ScopedLocker l(m_lock);
+      m_pool[seq % m_pool.size()] = frame;
+      m_head = seq;
+
+      for (size_t i = 0; i < m_readers.size(); i++) {
+        Reader *reader = m_readers[i];
+
+        if (!reader) {
+          continue;
+        }
+
+        reader->produced++;
+
+        if (reader->queue.size() >= reader->depth) {
+          if (reader->policy == OVERRUN_BLOCK && reader->block_ms > 0) {
+            blocked.push_back(reader);
+            continue;
+          }
+
+          if (reader->policy == OVERRUN_DROP_NEWEST) {
+            reader->overwritten++;
+            continue;
+          }
+
+          reader->queue.pop_front();
+          reader->overwritten++;
+        }
+
+        reader->queue.push_back(frame);
+        reader->event.set();
+      }
+    }
+
+    if (!blocked.empty()) {
+      waitForSpace(blocked, frame);
+    }
+
+    return seq;
+  }
+
+  /*!
+   * @brief wait for the next frame of a consumer \n
+   * @param[in]  id      consumer id
+   * @param[out] frame   下一帧数据
+   * @param[in]  timeout 超时时间(ms)
+   * @param[out] lost    frames dropped since the previous frame of this consumer, may be NULL
+   * @return 返回执行结果
+   * @retval RESULT_OK       获取成功
+   * @retval RESULT_TIMEOUT  等待超时
+   * @retval RESULT_FAIL     未知consumer或已关闭
+   */
+  result_t next(int id, std::shared_ptr<const ScanFrame> &frame,
+                uint32_t timeout, uint64_t *lost = NULL) {
+    return take(id, 1, timeout, &frame, NULL, lost);
+  }
+
+  /*!
+   * @brief drain every queued frame of a consumer at once \n
+   * Waits for the first frame only, then takes up to max frames under a
+   * single lock acquisition.
+   * @param[in]  id      consumer id
+   * @param[out] frames  appended frames, oldest first
+   * @param[in]  max     最多获取的圈数
+   * @param[in]  timeout 超时时间(ms)
+   * @param[out] lost    frames dropped since the previous frame of this consumer, may be NULL
+   * @return 返回执行结果
+   * @retval RESULT_OK       获取成功
+   * @retval RESULT_TIMEOUT  等待超时
+   * @retval RESULT_FAIL     未知consumer或已关闭
+   */
+  result_t drain(int id, std::vector<std::shared_ptr<const ScanFrame> > &frames,
+                 size_t max, uint32_t timeout, uint64_t *lost = NULL) {
+    return take(id, max, timeout, NULL, &frames, lost);
+  }
+
+  /*!
+   * @brief get the scan accounting of a consumer \n
+   * @param[in]  id    consumer id
+   * @param[out] stats 统计信息
+   * @return false if the consumer is unknown
+   */
+  bool getStats(int id, ScanConsumerStats &stats) {
+    ScopedLocker l(m_lock);
+
+    if (id < 0 || id >= static_cast<int>(m_readers.size()) || !m_readers[id]) {
+      return false;
+    }
+
+    const Reader *reader = m_readers[id];
+    stats.produced = reader->produced;
+    stats.delivered = reader->delivered;
+    stats.overwritten = reader->overwritten;
+    stats.pending = reader->queue.size();
+    return true;
+  }
+
+  /*!
+   * @brief close or reopen the broadcast \n
+   * Closing wakes every blocked consumer, ::next then fails once drained.
+   */
+  void setClosed(bool closed) {
+    ScopedLocker l(m_lock);
+    m_closed = closed;
+
+    if (closed) {
+      for (size_t i = 0; i < m_readers.size(); i++) {
+        if (m_readers[i]) {
+          m_readers[i]->event.set();
+        }
+      }
+    }
+  }
+
+ private:
+  ScanBroadcast(const ScanBroadcast &);
+  ScanBroadcast &operator=(const ScanBroadcast &);
+
+  struct Reader {
+    OverrunPolicy policy;
+    uint32_t      block_ms;     ///< OVERRUN_BLOCK最长阻塞时间
+    size_t        depth;        ///< 最多排队的圈数
+    uint64_t      last_seq;     ///< last delivered sequence number
+    uint64_t      produced;
+    uint64_t      delivered;
+    uint64_t      overwritten;
+    std::deque<std::shared_ptr<const ScanFrame> > queue;
+    Event         event;        ///< set on every queued frame
+    Event         space;        ///< set on every delivered frame
+  };
+
+  /*!
+   * @brief wait for and pop up to max frames \n
+   * into frame, or appended to frames when frame is NULL.
+   */
+  result_t take(int id, size_t max, uint32_t timeout,
+                std::shared_ptr<const ScanFrame> *frame,
+                std::vector<std::shared_ptr<const ScanFrame> > *frames,
+                uint64_t *lost) {
+    uint32_t startTs = getms();
+    uint32_t waitTime = 0;
+
+    if (lost) {
+      *lost = 0;
+    }
+
+    if (max == 0) {
+      return RESULT_FAIL;
+    }
+
+    while (true) {
+      Reader *reader = NULL;
+      {
+        ScopedLocker l(m_lock);
+
+        if (id < 0 || id >= static_cast<int>(m_readers.size()) || !m_readers[id]) {
+          return RESULT_FAIL;
+        }
+
+        reader = m_readers[id];
+
+        if (!reader->queue.empty()) {
+          for (size_t i = 0; i < max && !reader->queue.empty(); i++) {
+            const std::shared_ptr<const ScanFrame> &front = reader->queue.front();
+
+            if (lost) {
+              *lost += front->seq - reader->last_seq - 1;
+            }
+
+            reader->last_seq = front->seq;
+            reader->delivered++;
+
+            if (frame) {
+              *frame = front;
+            } else {
+              frames->push_back(front);
+            }
+
+            reader->queue.pop_front();
+          }
+
+          reader->space.set();
+          return RESULT_OK;
+        }
+
+        if (m_closed) {
+          return RESULT_FAIL;
+        }
+      }
+
+      waitTime = getms() - startTs;
+
+      if (waitTime >= timeout ||
+          reader->event.wait(timeout - waitTime) != Event::EVENT_OK) {
+        return RESULT_TIMEOUT;
+      }
+    }
+  }
+
+  /*!
+   * @brief queue a frame for OVERRUN_BLOCK consumers whose queue was full \n
+   * Waits for each of them within its own bound, measured from now, then
+   * drops their oldest frame.
+   */
+  void waitForSpace(const std::vector<Reader *> &blocked,
+                    const std::shared_ptr<ScanFrame> &frame) {
+    uint32_t startTs = getms();
+
+    for (size_t i = 0; i < blocked.size(); i++) {
+      Reader *reader = blocked[i];
+
+      while (true) {
+        {
+          ScopedLocker l(m_lock);
+
+          //removed while we waited
+          if (std::find(m_readers.begin(), m_readers.end(), reader) ==
+              m_readers.end()) {
+            break;
+          }
+
+          uint32_t waitTime = getms() - startTs;
+
+          if (reader->queue.size() < reader->depth || m_closed ||
+              waitTime >= reader->block_ms) {
+            if (reader->queue.size() >= reader->depth) {
+              reader->queue.pop_front();
+              reader->overwritten++;
+            }
+
+            reader->queue.push_back(frame);
+            reader->event.set();
+            break;
+          }
+        }
+
+        uint32_t waitTime = getms() - startTs;
+
+        if (waitTime < reader->block_ms) {
+          reader->space.wait(reader->block_ms - waitTime);
+        }
+      }
+    }
+  }
+
+  Locker m_lock;
+  size_t m_depth;                   ///< 默认每个消费者最多排队的圈数
+  std::vector<std::shared_ptr<ScanFrame> > m_pool;  ///< recycled frames
+  std::vector<Reader *> m_readers;
+  std::vector<Reader *> m_retired;  ///< removed readers, a waiter may still hold one
+  uint64_t m_head;                  ///< last published sequence number
+  std::atomic<int> m_consumers;
+  bool m_closed;
+};
+
+}// namespace ydlidar
@@ -0,0 +1,294 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "v8stdint.h"
+#include "ydlidar_protocol.h"
+#include "locker.h"
+#include "angles.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace ydlidar {
+
+/*!
+ * @brief Bounded, time indexed history of the latest scans.
+ * @note Scans are stored once as shared read-only pointers, so every
+ * subscriber can align against the same history without keeping copies.\n
+ * Point i of a scan is taken as measured at stamp + i * time_increment.\n
+ * All queries are thread safe.
+ */
+class ScanHistory {
+ public:
+  typedef std::shared_ptr<const LaserScan> ScanPtr;
+
+  /*!
+   * @param[in] duration 保留时长(ns), 0: 不保留
+   */
+  explicit ScanHistory(uint64_t duration = 0) : m_duration(duration) {
+  }
+
+  void setDuration(uint64_t duration) {
+    ScopedLocker l(m_lock);
+    m_duration = duration;
+    trim();
+  }
+
+  //! lock free, so a producer can skip building scans nobody keeps.
+  uint64_t duration() const {
+    return m_duration.load();
+  }
+
+  size_t size() {
+    ScopedLocker l(m_lock);
+    return m_scans.size();
+  }
+
+  void clear() {
+    ScopedLocker l(m_lock);
+    m_scans.clear();
+  }
+
+  /*!
+   * @brief append the newest scan \n
+   * Scans older than ::duration before it are released.
+   */
+  void push(const ScanPtr &scan) {
+    ScopedLocker l(m_lock);
+
+    if (!m_duration || !scan) {
+      return;
+    }
+
+    //a scan from before the newest one means the clock jumped, start over.
+    if (!m_scans.empty() && scan->stamp < m_scans.back()->stamp) {
+      m_scans.clear();
+    }
+
+    m_scans.push_back(scan);
+    trim();
+  }
+
+  /*!
+   * @brief scan whose first point is closest to t \n
+   * @param[in] t 时间戳(ns)
+   * @return NULL if the history is empty
+   */
+  ScanPtr nearest(uint64_t t) {
+    ScopedLocker l(m_lock);
+
+    if (m_scans.empty()) {
+      return ScanPtr();
+    }
+
+    size_t index = lowerBound(t);
+
+    if (index == m_scans.size()) {
+      return m_scans.back();
+    }
+
+    if (index > 0 &&
+        t - m_scans[index - 1]->stamp < m_scans[index]->stamp - t) {
+      index--;
+    }
+
+    return m_scans[index];
+  }
+
+  /*!
+   * @brief scans whose first point lies in [t0, t1], oldest first \n
+   * @param[in]  t0    起始时间戳(ns)
+   * @param[in]  t1    结束时间戳(ns)
+   * @param[out] scans 激光数据
+   */
+  void range(uint64_t t0, uint64_t t1, std::vector<ScanPtr> &scans) {
+    ScopedLocker l(m_lock);
+    scans.clear();
+
+    for (size_t i = lowerBound(t0); i < m_scans.size() &&
+         m_scans[i]->stamp <= t1; i++) {
+      scans.push_back(m_scans[i]);
+    }
+  }
+
+  /*!
+   * @brief range at one angle, interpolated to time t \n
+   * The range at the angle is interpolated between the two neighbouring
+   * points of the scans measured just before and just after t, then
+   * linearly between those two measurements.
+   * @param[in]  angle 角度(rad), -PI~PI
+   * @param[in]  t     时间戳(ns)
+   * @param[out] value 距离(m)
+   * @return false if t is not covered by two scans, or either reading is invalid
+   */
+  bool rangeAt(float angle, uint64_t t, float &value) {
+    ScopedLocker l(m_lock);
+    size_t index = lowerBound(t);
+    //the sample at the angle may be measured up to one scan after the
+    //scan start, so look one scan further back.
+    size_t first = index > 1 ? index - 2 : 0;
+    size_t last = std::min(index + 1, m_scans.size());
+    bool has_before = false;
+    uint64_t t_before = 0;
+    float before = 0.f;
+
+    for (size_t i = first; i < last; i++) {
+      uint64_t sample_time;
+      float sample;
+
+      if (!sampleAt(*m_scans[i], angle, sample_time, sample)) {
+        continue;
+      }
+
+      if (sample_time <= t) {
+        has_before = true;
+        t_before = sample_time;
+        before = sample;
+        continue;
+      }
+
+      if (!has_before || before <= 0.f || sample <= 0.f) {
+        return false;
+      }
+
+      float ratio = static_cast<float>(t - t_before) / (sample_time - t_before);
+      value = before + (sample - before) * ratio;
+      return true;
+    }
+
+    if (has_before && t == t_before && before > 0.f) {
+      value = before;
+      return true;
+    }
+
+    return false;
+  }
+
+ private:
+  ScanHistory(const ScanHistory &);
+  ScanHistory &operator=(const ScanHistory &);
+
+  void trim() {
+    if (!m_duration) {
+      m_scans.clear();
+      return;
+    }
+
+    while (!m_scans.empty() &&
+           m_scans.back()->stamp - m_scans.front()->stamp > m_duration) {
+      m_scans.pop_front();
+    }
+  }
+
+  /*!
+   * @brief index of the first scan starting at or after t
+   */
+  size_t lowerBound(uint64_t t) const {
+    size_t lo = 0;
+    size_t hi = m_scans.size();
+
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+
+      if (m_scans[mid]->stamp < t) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+
+    return lo;
+  }
+
+  /*!
+   * @brief range and time of one scan at an angle \n
+   * Interpolated between the closest valid points on either side.
+   */
+  static bool sampleAt(const LaserScan &scan, float angle, uint64_t &t,
+                       float &value) {
+    int below = -1;
+    int above = -1;
+    float below_diff = 0.f;
+    float above_diff = 0.f;
+
+    for (size_t i = 0; i < scan.points.size(); i++) {
+      const LaserPoint &point = scan.points[i];
+
+      if (point.range <= 0.f) {
+        continue;
+      }
+
+      float diff = angles::normalize_angle(point.angle - angle);
+
+      if (diff <= 0.f && (below < 0 || diff > below_diff)) {
+        below = i;
+        below_diff = diff;
+      }
+
+      if (diff >= 0.f && (above < 0 || diff < above_diff)) {
+        above = i;
+        above_diff = diff;
+      }
+    }
+
+    if (below < 0 || above < 0) {
+      return false;
+    }
+
+    //neighbours further apart than a few resolution steps leave a gap.
+    float span = above_diff - below_diff;
+
+    if (span > 4 * std::max(scan.config.angle_increment, 0.001f)) {
+      return false;
+    }
+
+    float ratio = span > 0.f ? -below_diff / span : 0.f;
+    value = scan.points[below].range +
+            (scan.points[above].range - scan.points[below].range) * ratio;
+    //the neighbours may sit on both ends of the scan, so take the closer
+    //one's time rather than interpolating the index.
+    int index = ratio < 0.5f ? below : above;
+    t = scan.stamp + static_cast<uint64_t>(index * scan.config.time_increment *
+                                           1e9);
+    return true;
+  }
+
+  Locker m_lock;
+  std::atomic<uint64_t> m_duration; ///< 保留时长(ns)
+  std::deque<ScanPtr> m_scans;  ///< 按时间排序的激光数据
+};
+
+}// namespace ydlidar
@@ -0,0 +1,171 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#pragma once
+#include "v8stdint.h"
+#include "ydlidar_protocol.h"
+#include <atomic>
+#include <vector>
+
+namespace ydlidar {
+
+/*!
+ * @brief latest sample of one angle bin
+ */
+struct ScanWindowBin {
+  uint16_t   sync_quality;       ///< 信号质量
+  uint16_t   angle_q6_checkbit;  ///< 测距点角度
+  uint16_t   distance_q2;        ///< 测距点距离
+  uint64_t   stamp;              ///< 测量时刻(ns), 0表示该角度尚无数据
+  uint64_t   age;                ///< 快照时刻距测量时刻的时间(ns)
+};
+
+/*!
+ * @brief Rolling 360 degree view of the latest sample at each angle bin.
+ * @note One writer(the driver) updates the bins package by package,
+ * any number of readers take lock-free snapshots.\n
+ * Every bin is protected by its own sequence counter, so a reader never
+ * blocks the writer and retries only the bins updated while it was reading.
+ */
+class ScanWindow {
+ public:
+  explicit ScanWindow(size_t bins = 720) : m_size(bins > 0 ? bins : 1) {
+    m_slots = new Slot[m_size];
+
+    for (size_t i = 0; i < m_size; i++) {
+      m_slots[i].seq = 0;
+      m_slots[i].sync_quality = 0;
+      m_slots[i].angle_q6_checkbit = 0;
+      m_slots[i].distance_q2 = 0;
+      m_slots[i].stamp = 0;
+    }
+  }
+
+  ~ScanWindow() {
+    delete[] m_slots;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  /*!
+   * @brief update bins with the nodes of one package \n
+   * @param[in] nodes      激光点信息
+   * @param[in] count      激光点数
+   * @param[in] end_stamp  最后一个点的测量时刻(ns)
+   * @param[in] point_time 采样间隔(ns)
+   * @note must only be called from a single writer thread
+   */
+  void update(const node_info *nodes, size_t count, uint64_t end_stamp,
+              uint64_t point_time) {
+    for (size_t i = 0; i < count; i++) {
+      uint16_t angle_q6 = nodes[i].angle_q6_checkbit >>
+                          LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT;
+
+      //checksum error node
+      if (nodes[i].distance_q2 == 0 && angle_q6 == 0) {
+        continue;
+      }
+
+      size_t index = (size_t)angle_q6 * m_size / (360 * 64);
+
+      if (index >= m_size) {
+        index = m_size - 1;
+      }
+
+      Slot &slot = m_slots[index];
+      uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+      slot.seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.sync_quality.store(nodes[i].sync_quality, std::memory_order_relaxed);
+      slot.angle_q6_checkbit.store(nodes[i].angle_q6_checkbit,
+                                   std::memory_order_relaxed);
+      slot.distance_q2.store(nodes[i].distance_q2, std::memory_order_relaxed);
+      slot.stamp.store(end_stamp - (count - 1 - i) * point_time,
+                       std::memory_order_relaxed);
+      slot.seq.store(seq + 2, std::memory_order_release);
+    }
+  }
+
+  /*!
+   * @brief take a snapshot of all bins \n
+   * @param[out] bins  bin array, resized to ::size
+   * @param[in]  now   snapshot time(ns), used to compute the bin age
+   */
+  void snapshot(std::vector<ScanWindowBin> &bins, uint64_t now) const {
+    bins.resize(m_size);
+
+    for (size_t i = 0; i < m_size; i++) {
+      const Slot &slot = m_slots[i];
+      ScanWindowBin &bin = bins[i];
+      uint32_t begin = 0;
+      uint32_t end = 0;
+
+      do {
+        begin = slot.seq.load(std::memory_order_acquire);
+
+        if (begin & 1) {
+          continue;
+        }
+
+        bin.sync_quality = slot.sync_quality.load(std::memory_order_relaxed);
+        bin.angle_q6_checkbit = slot.angle_q6_checkbit.load(
+                                  std::memory_order_relaxed);
+        bin.distance_q2 = slot.distance_q2.load(std::memory_order_relaxed);
+        bin.stamp = slot.stamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        end = slot.seq.load(std::memory_order_relaxed);
+      } while ((begin & 1) || begin != end);
+
+      bin.age = (bin.stamp != 0 && now > bin.stamp) ? now - bin.stamp : 0;
+    }
+  }
+
+ private:
+  ScanWindow(const ScanWindow &);
+  ScanWindow &operator=(const ScanWindow &);
+
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint16_t> sync_quality;
+    std::atomic<uint16_t> angle_q6_checkbit;
+    std::atomic<uint16_t> distance_q2;
+    std::atomic<uint64_t> stamp;
+  };
+
+  Slot *m_slots;
+  size_t m_size;
+};
+
+}// namespace ydlidar
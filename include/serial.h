@@ -571,6 +571,17 @@ class Serial  {
   /*! Returns the singal byte time. */
   int getByteTime();
 
+  /*! Returns the file descriptor of the serial port,
+  * -1 if the port is not open or the platform has none.
+  * The descriptor can be polled for readability by an external event loop. */
+  int getFileDescriptor();
+
+  /*! Registers a wake-up descriptor owned by the caller, -1 to remove it.
+  * While it is readable, waitfordata returns at once as timed out, so a
+  * thread blocked on the port can be stopped without being cancelled.
+  * Ignored on platforms without file descriptors. */
+  void setWakeupDescriptor(int fd);
+
 
  private:
   // Disable copy constructors
@@ -609,9 +620,15 @@ struct PortInfo {
   /*! Hardware Device ID or "" if not available. */
   std::string device_id;
 
+  /*! USB serial number of the adapter or "" if not available. */
+  std::string serial_number;
+
+  /*! Physical USB port of the adapter, stable across reboots, or "" if not available. */
+  std::string usb_path;
+
 };
 
-/* Lists the serial ports available on the system
+/* Lists the serial ports of the known LiDAR USB serial adapters
 *
 * Returns a vector of available serial ports, each represented
 * by a serial::PortInfo data structure:
@@ -621,6 +638,21 @@ struct PortInfo {
 std::vector<PortInfo>
 list_ports();
 
+/* Lists the USB serial ports matching an adapter and serial number
+*
+* Only USB serial devices are looked at, and the remaining attributes of a
+* device are only read once its VID:PID matched.
+*
+* \param vid_pids VID:PID of the adapters as lower case hex, e.g. "10c4:ea60",
+* any adapter if empty.
+* \param serial_number USB serial number, any if empty.
+*
+* \return vector of serial::PortInfo.
+*/
+std::vector<PortInfo>
+list_ports(const std::vector<std::string> &vid_pids,
+           const std::string &serial_number = std::string());
+
 } // namespace serial
 
 #endif
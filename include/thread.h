@@ -9,6 +9,15 @@
 #else
 #include <pthread.h>
 #include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <time.h>
 #endif
 
 #define UNUSED(x) (void)x
@@ -18,6 +27,28 @@
 #endif
 
 #define CLASS_THREAD(c , x ) Thread::ThreadCreateObjectFunctor<c, &c::x>(this)
+#define CLASS_THREAD_OPTIONS(c , x, o) Thread::ThreadCreateObjectFunctor<c, &c::x>(this, o)
+
+/**
+ * Scheduling options applied when a thread is created.
+ * Failures are reported on stderr and the thread keeps running with
+ * whatever could be applied.
+ */
+struct ThreadOptions {
+  enum {
+    POLICY_DEFAULT = 0, /**< inherit the normal time-sharing policy. */
+    POLICY_FIFO,        /**< SCHED_FIFO */
+    POLICY_RR,          /**< SCHED_RR */
+  };
+
+  int policy;
+  int priority;        ///< real-time priority, 1~99 for FIFO/RR
+  uint64_t cpu_mask;   ///< bit i pins to CPU i, 0: no pinning
+  size_t stack_size;   ///< preallocated and prefaulted stack in bytes, 0: default
+
+  ThreadOptions(): policy(POLICY_DEFAULT), priority(0), cpu_mask(0),
+    stack_size(0) {}
+};
 
 class Thread {
  public:
@@ -27,6 +58,11 @@ class Thread {
     return createThread(createThreadAux<CLASS, PROC>, pthis);
   }
 
+  template <class CLASS, int (CLASS::*PROC)(void)> static Thread
+  ThreadCreateObjectFunctor(CLASS *pthis, const ThreadOptions &options) {
+    return createThread(createThreadAux<CLASS, PROC>, pthis, options);
+  }
+
   template <class CLASS, int (CLASS::*PROC)(void) > static _size_t THREAD_PROC
   createThreadAux(void *param) {
     return (static_cast<CLASS *>(param)->*PROC)();
@@ -46,8 +82,139 @@ class Thread {
     return thread_;
   }
 
+  static Thread createThread(thread_proc_t proc, void *param,
+                             const ThreadOptions &options) {
+    Thread thread_(proc, param);
+#if defined(_WIN32)
+    thread_._handle = (_size_t)(_beginthreadex(NULL, (unsigned)options.stack_size,
+                                (unsigned int (__stdcall *)(void *))proc, param, 0, NULL));
+
+    if (!thread_._handle) {
+      return thread_;
+    }
+
+    if (options.policy != ThreadOptions::POLICY_DEFAULT &&
+        !SetThreadPriority(reinterpret_cast<HANDLE>(thread_._handle),
+                           THREAD_PRIORITY_TIME_CRITICAL)) {
+      fprintf(stderr, "Failed to raise thread priority: %lu\n", GetLastError());
+    }
+
+    if (options.cpu_mask &&
+        !SetThreadAffinityMask(reinterpret_cast<HANDLE>(thread_._handle),
+                               (DWORD_PTR)options.cpu_mask)) {
+      fprintf(stderr, "Failed to set thread affinity: %lu\n", GetLastError());
+    }
+
+#else
+    assert(sizeof(thread_._handle) >= sizeof(pthread_t));
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+
+    if (options.stack_size) {
+      size_t page = sysconf(_SC_PAGESIZE);
+      size_t size = (options.stack_size + page - 1) / page * page;
+
+      if (size < (size_t)PTHREAD_STACK_MIN) {
+        size = (size_t)PTHREAD_STACK_MIN;
+      }
+
+      if (posix_memalign(&thread_._stack, page, size) == 0) {
+        //touch every page now, so the thread never faults on its stack.
+        memset(thread_._stack, 0, size);
+        pthread_attr_setstack(&attr, thread_._stack, size);
+      } else {
+        thread_._stack = NULL;
+        fprintf(stderr, "Failed to allocate a %lu bytes thread stack\n",
+                (unsigned long)size);
+      }
+    }
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+    if (options.cpu_mask) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+
+      for (int i = 0; i < 64 && i < CPU_SETSIZE; i++) {
+        if (options.cpu_mask & (1ULL << i)) {
+          CPU_SET(i, &cpus);
+        }
+      }
+
+      pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    }
+
+#endif
+
+    //set on the attributes, so the thread never runs at the default priority.
+    if (options.policy != ThreadOptions::POLICY_DEFAULT) {
+      struct sched_param param_;
+      param_.sched_priority = options.priority;
+      pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&attr,
+                                  options.policy == ThreadOptions::POLICY_FIFO ? SCHED_FIFO : SCHED_RR);
+      pthread_attr_setschedparam(&attr, &param_);
+    }
+
+    int ret = pthread_create((pthread_t *)&thread_._handle, &attr,
+                             (void *(*)(void *))proc, param);
+
+    if (ret != 0 && options.policy != ThreadOptions::POLICY_DEFAULT) {
+      if (ret == EPERM) {
+        fprintf(stderr, "Failed to set real-time priority %d: permission denied, "
+                "requires CAP_SYS_NICE or RLIMIT_RTPRIO >= %d\n",
+                options.priority, options.priority);
+      } else {
+        fprintf(stderr, "Failed to set real-time priority %d: %s\n",
+                options.priority, strerror(ret));
+      }
+
+      pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+      ret = pthread_create((pthread_t *)&thread_._handle, &attr,
+                           (void *(*)(void *))proc, param);
+    }
+
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+      fprintf(stderr, "Failed to create thread: %s\n", strerror(ret));
+      fflush(stderr);
+      free(thread_._stack);
+      thread_._stack = NULL;
+      thread_._handle = 0;
+      return thread_;
+    }
+
+#endif
+    fflush(stderr);
+    return thread_;
+  }
+
+  /**
+   * Locks all current and future pages of the process in RAM.
+   * This affects the whole process, not one thread, so call it once at
+   * start up if page faults must never stall a real-time thread.
+   * Requires CAP_IPC_LOCK or a large enough RLIMIT_MEMLOCK.
+   * @return true on success, false on failure or where not supported
+   */
+  static bool lockProcessMemory() {
+#if defined(_WIN32)
+    return false;
+#else
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      fprintf(stderr, "Failed to lock memory: %s, "
+              "requires CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK\n", strerror(errno));
+      fflush(stderr);
+      return false;
+    }
+
+    return true;
+#endif
+  }
+
  public:
-  explicit Thread(): _param(NULL), _func(NULL), _handle(0) {}
+  explicit Thread(): _param(NULL), _func(NULL), _handle(0), _stack(NULL) {}
   virtual ~Thread() {}
   _size_t getHandle() {
     return _handle;
@@ -79,43 +246,71 @@ class Thread {
   void *getParam() {
     return _param;
   }
+  /**
+   * Waits for the thread to return.
+   * @param timeout bound in ms, -1 waits forever. The thread is never
+   * cancelled, since it may hold locks; one still running at the bound keeps
+   * its handle, and the caller decides whether to join again. Without
+   * pthread_timedjoin_np (non-Linux POSIX) the bound is ignored.
+   * @return 0 on success, -1 on timeout, -2 on failure
+   */
   int join(unsigned long timeout = -1) {
     if (!this->_handle) {
       return 0;
     }
 
 #if defined(_WIN32)
+    DWORD ret = WaitForSingleObject(reinterpret_cast<HANDLE>(this->_handle),
+                                    timeout);
 
-    switch (WaitForSingleObject(reinterpret_cast<HANDLE>(this->_handle), timeout)) {
-      case WAIT_OBJECT_0:
-        CloseHandle(reinterpret_cast<HANDLE>(this->_handle));
-        this->_handle = NULL;
-        return 0;
-
-      case WAIT_ABANDONED:
-        return -2;
+    if (ret == WAIT_TIMEOUT) {
+      return -1;
+    }
 
-      case WAIT_TIMEOUT:
-        return -1;
+    if (ret != WAIT_OBJECT_0) {
+      return -2;
     }
 
+    CloseHandle(reinterpret_cast<HANDLE>(this->_handle));
+    this->_handle = NULL;
 #else
-    UNUSED(timeout);
-    void *res;
-    int s = -1;
-    s = pthread_cancel((pthread_t)(this->_handle));
+    void *res = NULL;
+    int s = ETIMEDOUT;
+#if defined(__linux__) && !defined(__ANDROID__)
 
-    if (s != 0) {
+    if (timeout != (unsigned long) -1) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += timeout / 1000;
+      deadline.tv_nsec += (timeout % 1000) * 1000000;
+
+      if (deadline.tv_nsec >= 1000000000) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000;
+      }
+
+      s = pthread_timedjoin_np((pthread_t)(this->_handle), &res, &deadline);
+
+      if (s == ETIMEDOUT) {
+        return -1;
+      }
     }
 
-    s = pthread_join((pthread_t)(this->_handle), &res);
+#endif
+
+    if (s == ETIMEDOUT) {
+      s = pthread_join((pthread_t)(this->_handle), &res);
+    }
 
     if (s != 0) {
+      return -2;
     }
 
-    if (res == PTHREAD_CANCELED) {
-      printf("%lu thread has been canceled\n", this->_handle);
-      this->_handle = 0;
+    this->_handle = 0;
+
+    if (this->_stack) {
+      free(this->_stack);
+      this->_stack = NULL;
     }
 
 #endif
@@ -127,9 +322,10 @@ class Thread {
   }
  protected:
   explicit Thread(thread_proc_t proc, void *param): _param(param), _func(proc),
-    _handle(0) {}
+    _handle(0), _stack(NULL) {}
   void *_param;
   thread_proc_t _func;
   _size_t _handle;
+  void *_stack;     ///< preallocated stack, released by join
 };
 
@@ -50,12 +50,19 @@
 #define YDLIDAR_DRIVER_H
 #include <stdlib.h>
 #include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <vector>
 #include "serial.h"
+#include "channel_device.h"
 #include "locker.h"
 #include "thread.h"
 #include "ydlidar_protocol.h"
 #include "help_info.h"
+#include "scan_window.h"
+#include "scan_broadcast.h"
+#include "hotplug_watcher.h"
 
 #if !defined(__cplusplus)
 #ifndef __cplusplus
@@ -121,6 +128,44 @@ class YDlidarDriver {
   * @see DriverInterface::setPointTime and DriverInterface::getPointTime
   */
   PropertyBuilderByName(uint32_t, PointTime,private);
+  /**
+  * @brief Set and Get scan seam angle.
+  * @note The LiDAR raw angle(unit: degree, Range: 0~360) at which a revolution is closed
+  * and published.\n
+  * A negative value(default) closes the revolution at the device sync bit.\n
+  * Choose an angle just after the safety-critical sector,
+  * so the sector is always the freshest part of every scan.
+  * @see DriverInterface::setScanSeamAngle and DriverInterface::getScanSeamAngle
+  */
+  PropertyBuilderByName(float, ScanSeamAngle, private);
+  /*!
+  * @brief Set and Get threadless mode.
+  * @note When true, ::startScan spawns no parsing thread.\n
+  * The caller polls ::getFileDescriptor in its own event loop
+  * and calls ::processReadable whenever the port is readable.\n
+  * ::grabScanData still works and parses inline, so it must not run concurrently
+  * with ::processReadable.\n
+  * Auto reconnect is not available; a failed ::processReadable is left to the caller.
+  * Change it only while not scanning.
+  */
+  PropertyBuilderByName(bool, Threadless, private);
+  /*!
+  * @brief Set and Get whether another thread's event loop calls ::processReadable.
+  * @note Threadless mode only. When true, ::grabScanData and the motor ready
+  * wait of ::startScan and ::continueScan wait for that loop instead of
+  * parsing the port from the calling thread.
+  */
+  PropertyBuilderByName(bool, ExternalLoop, private);
+  /*!
+  * @brief Set and Get parsing thread scheduling options.
+  * @note Real-time policy/priority, CPU affinity and a preallocated stack for
+  * the thread started by ::startScan, see Thread::lockProcessMemory to lock
+  * the process memory.\n
+  * Preempting the parsing thread overruns the tty buffer and drops packages.\n
+  * Missing privileges are reported on stderr and scanning still starts.
+  * @see ThreadOptions
+  */
+  PropertyBuilderByName(ThreadOptions, ThreadOptions, private);
   /*!
   * A constructor.
   * A more elaborate description of the constructor.
@@ -136,7 +181,7 @@ class YDlidarDriver {
   /*!
   * @brief 连接雷达 \n
   * 连接成功后，必须使用::disconnect函数关闭
-  * @param[in] port_path    串口号
+  * @param[in] port_path    串口号, 或tcp://、udp://、unix://、pipe://、file://等URI, 见::ChannelDevice
   * @param[in] baudrate    波特率，YDLIDAR-SS雷达波特率：
   *     230400 G2-SS-1
   * @return 返回连接状态
@@ -162,9 +207,47 @@ class YDlidarDriver {
   /*!
   * @brief lidarPortList 获取雷达端口
   * @return 在线雷达列表
+  * @note 使用缓存的端口表, 只在设备热插拔后重新枚举
   */
   static std::map<std::string, std::string> lidarPortList();
 
+  /*!
+  * @brief 按序列号获取雷达端口 \n
+  * 静态函数, 只列出雷达USB转串口适配器上的端口, 使用缓存的端口表,
+  * 只在设备热插拔后重新枚举
+  * @param[in] serial_number USB序列号, 为空时不过滤
+  * @return 在线雷达端口信息
+  */
+  static std::vector<PortInfo> lidarPortInfoList(
+    const std::string &serial_number = std::string());
+
+  /*!
+  * @brief 设置雷达使用的USB转串口适配器 \n
+  * 静态函数, 用于识别其它适配器上的雷达
+  * @param[in] vid_pids 适配器VID:PID, 小写十六进制, 如 "10c4:ea60",
+  * 为空时恢复默认适配器
+  */
+  static void setLidarAdapters(const std::vector<std::string> &vid_pids);
+
+  /*!
+  * @brief 自动识别串口上雷达的波特率与通信方式 \n
+  * 静态函数, 依次尝试常用波特率, 先被动监听 0x55AA 数据包头, 按带/不带信号质量
+  * 两种包长校验, 再以获取设备信息命令的 0xA5 0x5A 应答区分单双通道. \n
+  * 静默的单通道雷达需要拉高 DTR 启动电机后才能识别, 识别结束后会恢复 DTR.
+  * @param[in] port     串口号
+  * @param[out] info    识别出的配置
+  * @param[in] timeout  超时时间(ms)
+  * @return 返回执行结果
+  * @retval RESULT_OK       识别成功
+  * @retval RESULT_TIMEOUT  超时未识别
+  * @retval RESULT_FAIL     串口无法打开
+  * @note 单通道雷达无法获取型号, ::LidarDetectInfo::model 为 -1,
+  * 雷达类型按 [TYPE_TRIANGLE](\ref LidarTypeID::TYPE_TRIANGLE) 返回.\n
+  * 调用时该串口不能被其它驱动打开.
+  */
+  static result_t detectLidar(const std::string &port, LidarDetectInfo &info,
+                              uint32_t timeout = DEFAULT_DETECT_TIMEOUT);
+
 
   /*!
   * @brief 扫图状态 \n
@@ -194,6 +277,8 @@ class YDlidarDriver {
 
   /*!
   * @brief 设置雷达异常自动重新连接 \n
+  * 串口出错, 或连续(::DEFAULT_TIMEOUT_COUNT + 1) * ::DEFAULT_TIMEOUT(4s)
+  * 没有有效数据包时重新连接
   * @param[in] enable    是否开启自动重连:
   *     true	开启
   *	  false 关闭
@@ -237,6 +322,28 @@ class YDlidarDriver {
   */
   result_t stop();
 
+  /*!
+  * @brief 暂停扫描 \n
+  * 停止数据解析和扫描, 电机保持转动, 多消费者队列保持打开,
+  * 之后可以发送配置命令
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE    失败
+  * @see ::continueScan
+  */
+  result_t pauseScan();
+
+  /*!
+  * @brief 继续扫描 \n
+  * 重新开始扫描和数据解析, 等待电机转速稳定, 不做完整的启动流程
+  * @param[in] timeout      超时时间
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE or RESULT_TIMEOUT   失败, 消费者队列关闭
+  * @see ::pauseScan
+  */
+  result_t continueScan(uint32_t timeout = DEFAULT_TIMEOUT);
+
 
   /*!
   * @brief 获取激光数据 \n
@@ -251,6 +358,169 @@ class YDlidarDriver {
   result_t grabScanData(node_info *nodebuffer, size_t &count,
                         uint32_t timeout = DEFAULT_TIMEOUT) ;
 
+  /*!
+  * @brief 解析串口中已到达的数据 \n
+  * 无线程模式下, 串口可读时由调用者的事件循环调用, 不阻塞
+  * @param[out] scans 本次完成的整圈数据个数, 可为NULL
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功, ::pauseScan暂停中不读取数据
+  * @retval RESULT_FAILE    未扫描或串口异常
+  * @note 完成的一圈数据通过::grabScanData获取
+  */
+  result_t processReadable(size_t *scans = NULL);
+
+  /*!
+  * @brief 丢弃串口中已到达的数据, 不解析 \n
+  * 停止扫描后, 调用者的事件循环用它清空串口, 不阻塞
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE    未连接
+  */
+  result_t discardReadable();
+
+  /*!
+  * @brief 获取自动重连成功次数 \n
+  * 每次重连后, 缓存的雷达配置(型号, 采样率等)未经命令重新确认,
+  * 上层可据此用数据流中的信息做校验
+  * @return 重连次数
+  */
+  uint32_t getReconnectCount() const;
+
+  /*!
+  * @brief 数据中断回调 \n
+  * stalled为true: 超过::getDataTimeout未收到有效数据包; false: 数据恢复
+  */
+  typedef std::function<void(bool stalled)> StallCallback;
+
+  /*!
+  * @brief 设置数据中断回调 \n
+  * 在解析线程(无线程模式下为调用::checkWatchdog的线程)中调用, 不可阻塞
+  * @param[in] callback 回调函数
+  * @note 开始扫描前设置
+  */
+  void setStallCallback(const StallCallback &callback);
+
+  /*!
+  * @brief 获取数据中断超时时间 \n
+  * 由采样时间和数据包最大采样点数计算的若干个数据包时长,
+  * 收到第一个数据包前为::DEFAULT_TIMEOUT
+  * @return 超时时间(ms)
+  */
+  uint32_t getDataTimeout() const;
+
+  /*!
+  * @brief 检测数据是否中断 \n
+  * 状态变化时调用数据中断回调\n
+  * 解析线程自动调用; 无线程模式下, 事件循环以::getDataTimeout为超时等待,
+  * 每次唤醒后调用
+  * @return true: 数据中断
+  */
+  bool checkWatchdog();
+
+  /*!
+  * @brief 获取串口文件描述符 \n
+  * 用于在调用者的事件循环中等待串口可读
+  * @return 文件描述符, -1: 未连接或平台不支持
+  */
+  int getFileDescriptor();
+
+
+  /*!
+  * @brief 设置滚动360度窗口 \n
+  * 每收到一包数据, 更新各角度分区的最新激光点
+  * @param[in] bins 角度分区数, 0: 关闭
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE    失败
+  * @note 停止扫描后再执行当前操作
+  */
+  result_t setScanWindow(int bins);
+
+  /*!
+  * @brief 获取滚动360度窗口快照 \n
+  * 无锁, 可在任意线程任意时刻调用
+  * @param[in] bins 各角度分区最新激光点及其时间
+  * @return 返回执行结果
+  * @retval RESULT_OK       获取成功
+  * @retval RESULT_FAILE    窗口未开启
+  */
+  result_t getScanWindow(std::vector<ScanWindowBin> &bins);
+
+  /*!
+  * @brief 获取整圈数据通知描述符 \n
+  * 有新的一圈数据时可读, 成功调用::grabScanData后清除
+  * @return 文件描述符, 可用于select/poll/epoll, -1: 平台不支持
+  */
+  int getScanEventFd() const;
+
+  /*!
+  * @brief 获取滚动窗口更新通知描述符 \n
+  * 滚动360度窗口每更新一包数据时可读, 调用::getScanWindow后清除
+  * @return 文件描述符, 可用于select/poll/epoll, -1: 平台不支持
+  */
+  int getSectorEventFd() const;
+
+  /*!
+  * @brief 注册整圈数据消费者 \n
+  * 每个消费者有独立的队列, 互不抢占数据, 多个消费者共享同一份数据, 不做拷贝
+  * @param[in] policy   队列满时的处理策略
+  * @param[in] block_ms OVERRUN_BLOCK时解析线程最长阻塞时间(ms)
+  * @param[in] depth    最多排队的圈数, 0: 默认8圈
+  * @return 消费者id
+  */
+  int addScanConsumer(OverrunPolicy policy = OVERRUN_DROP_OLDEST,
+                      uint32_t block_ms = 0, size_t depth = 0);
+
+  /*!
+  * @brief 注销整圈数据消费者 \n
+  * @param[in] id 消费者id
+  */
+  void removeScanConsumer(int id);
+
+  /*!
+  * @brief 获取消费者的下一圈数据 \n
+  * @param[in]  id      消费者id
+  * @param[out] frame   一圈数据, 带连续的序号
+  * @param[in]  timeout 超时时间
+  * @param[out] lost    读取前被覆盖而丢失的圈数, 可为NULL
+  * @return 返回执行结果
+  * @retval RESULT_OK       获取成功
+  * @retval RESULT_TIMEOUT  等待超时
+  * @retval RESULT_FAILE    未知消费者或已停止扫描
+  * @note 与::grabScanData互不影响
+  */
+  result_t grabScanFrame(int id, std::shared_ptr<const ScanFrame> &frame,
+                         uint32_t timeout = DEFAULT_TIMEOUT,
+                         uint64_t *lost = NULL);
+
+  /*!
+  * @brief 一次获取消费者排队的所有整圈数据 \n
+  * 只等待第一圈, 之后一次加锁取出最多max圈
+  * @param[in]  id      消费者id
+  * @param[out] frames  追加的整圈数据, 按时间先后排列
+  * @param[in]  max     最多获取的圈数
+  * @param[in]  timeout 超时时间
+  * @param[out] lost    丢失的圈数, 可为NULL
+  * @return 返回执行结果
+  * @retval RESULT_OK       获取成功
+  * @retval RESULT_TIMEOUT  等待超时
+  * @retval RESULT_FAILE    未知消费者或已停止扫描
+  */
+  result_t grabScanFrames(int id,
+                          std::vector<std::shared_ptr<const ScanFrame> > &frames,
+                          size_t max, uint32_t timeout = DEFAULT_TIMEOUT,
+                          uint64_t *lost = NULL);
+
+  /*!
+  * @brief 获取整圈数据统计 \n
+  * @param[in]  id    消费者id, 小于0: ::grabScanData的数据
+  * @param[out] stats 发布, 读取, 丢弃的圈数
+  * @return 返回执行结果
+  * @retval RESULT_OK       获取成功
+  * @retval RESULT_FAILE    未知消费者
+  * @note ::grabScanData的统计在每次开始扫描时清零
+  */
+  result_t getScanStats(int id, ScanConsumerStats &stats);
 
   /*!
   * @brief 补偿激光角度 \n
@@ -276,20 +546,30 @@ class YDlidarDriver {
 
   /*!
   * @brief 打开电机 \n
+  * 扫描中等待转速稳定(连续几圈时长一致), 最长 MOTOR_READY_TIMEOUT,
+  * 否则固定等待 DEFAULT_MOTOR_DELAY
     * @return 返回执行结果
     * @retval RESULT_OK       成功
+    * @retval RESULT_TIMEOUT  超时仍未稳定
     * @retval RESULT_FAILE    失败
     */
   result_t startMotor();
 
   /*!
   * @brief 关闭电机 \n
+  * 停止扫描后, 等到串口没有数据为止, 最长 DEFAULT_MOTOR_DELAY
     * @return 返回执行结果
     * @retval RESULT_OK       成功
     * @retval RESULT_FAILE    失败
     */
   result_t stopMotor();
 
+  /*!
+  * @brief 电机转速是否已稳定 \n
+  * 每次开始扫描后重新判断
+  */
+  bool isMotorReady() const;
+
   /*!
   * @brief 获取激光雷达当前扫描频率 \n
   * @param[in] frequency    扫描频率
@@ -386,7 +666,71 @@ class YDlidarDriver {
   result_t getZeroOffsetAngle(offset_angle &angle,
                               uint32_t timeout = DEFAULT_TIMEOUT);
 
+  /*!
+  * @brief 打开低功耗模式 \n
+  * 空闲(不扫描)时电机停转
+  * @param[in] state　　　   执行后的功能状态
+  * @param[in] timeout      超时时间
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE    失败
+  * @note 停止扫描后再执行当前操作, 单通道雷达不支持
+  */
+  result_t enableLowPower(function_state &state,
+                          uint32_t timeout = DEFAULT_TIMEOUT);
+
+  /*!
+  * @brief 关闭低功耗模式 \n
+  * @param[in] state　　　   执行后的功能状态
+  * @param[in] timeout      超时时间
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE    失败
+  * @note 停止扫描后再执行当前操作, 单通道雷达不支持
+  */
+  result_t disableLowPower(function_state &state,
+                           uint32_t timeout = DEFAULT_TIMEOUT);
+
+  /*!
+  * @brief 获取电机状态 \n
+  * @param[in] state　　　   电机状态, 非零表示转动
+  * @param[in] timeout      超时时间
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_FAILE    失败
+  * @note 停止扫描后再执行当前操作, 单通道雷达不支持
+  */
+  result_t getMotorState(function_state &state,
+                         uint32_t timeout = DEFAULT_TIMEOUT);
+
+  /*!
+  * @brief 批量发送命令 \n
+  * 所有命令一次写入串口, 再按顺序收取应答, 整批只需一个往返时间
+  * @param[in] cmds         无负载的命令, 应答类型均为 LIDAR_ANS_TYPE_DEVINFO
+  * @param[in] reply_size   每条应答的数据长度
+  * @param[out] replies     按顺序拼接的应答数据, 出错时只含已收到的部分
+  * @param[in] timeout      每条应答的超时时间
+  * @return 返回执行结果
+  * @retval RESULT_OK       成功
+  * @retval RESULT_TIMEOUT  等待应答超时
+  * @retval RESULT_FAILE    失败
+  * @note 停止扫描后再执行当前操作
+  */
+  result_t sendCommandBatch(const std::vector<uint8_t> &cmds,
+                            size_t reply_size, std::vector<uint8_t> &replies,
+                            uint32_t timeout = DEFAULT_TIMEOUT);
+
  protected:
+  /*!
+  * @brief 发送应答为一个字节功能状态的命令
+  * @param[in] cmd          命令
+  * @param[in] state　　　   功能状态
+  * @param[in] timeout      超时时间
+  * @return 返回执行结果
+  */
+  result_t sendStateCommand(uint8_t cmd, function_state &state,
+                            uint32_t timeout);
+
 
   /*!
   * @brief 创建解析雷达数据线程 \n
@@ -434,6 +778,44 @@ class YDlidarDriver {
   */
   result_t waitPackage(node_info *node, uint32_t timeout = DEFAULT_TIMEOUT);
 
+  /*!
+  * @brief 当前包剩余字节数 \n
+  */
+  size_t packageRemainSize() const;
+
+  /*!
+  * @brief 解析一个字节 \n
+  * @param[in] currentByte 串口数据
+  * @return 返回是否收到完整数据包
+  */
+  bool parsePackageByte(uint8_t currentByte);
+
+  /*!
+  * @brief 从已收到的数据包中取出下一个激光点 \n
+  * @param[in] node 解包后激光点信息
+  */
+  void parsePackageNode(node_info *node);
+
+  /*!
+  * @brief 计算串口缓存数据的延时 \n
+  * @param[in] size 串口缓存字节数
+  * @return 延时(ns)
+  */
+  uint64_t getPendingDelay(size_t size) const;
+
+  /*!
+  * @brief 重置解包及整圈拼接状态 \n
+  */
+  void resetScanParser();
+
+  /*!
+  * @brief 拼接激光点, 完成一圈后发布 \n
+  * @param[in] nodes 激光点信息
+  * @param[in] count 激光点数
+  * @return 返回发布的整圈数据个数
+  */
+  size_t handleScanNodes(node_info *nodes, size_t count);
+
   /*!
   * @brief 发送数据到雷达 \n
   * @param[in] nodebuffer 激光信息指针
@@ -452,8 +834,16 @@ class YDlidarDriver {
   */
   int cacheScanData();
 
+  /*!
+  * @brief 是否到达扫描接缝角 \n
+  * @param[in] node 激光点信息
+  * @return 返回是否需要在当前点结束一圈数据
+  */
+  bool isScanSeam(const node_info &node);
+
   /*!
   * @brief 发送数据到雷达 \n
+  * 整条命令一次写入
   * @param[in] cmd 	 命名码
   * @param[in] payload      payload
   * @param[in] payloadsize      payloadsize
@@ -522,6 +912,12 @@ class YDlidarDriver {
   */
   void disableDataGrabbing();
 
+  /*!
+  * @brief 等待解析线程退出 \n
+  * 超过::DEFAULT_STOP_TIMEOUT告警, 之后继续等待
+  */
+  void joinThread();
+
   /*!
   * @brief 设置串口DTR \n
   */
@@ -537,6 +933,47 @@ class YDlidarDriver {
    */
   void flushSerial();
 
+  /*!
+   * @brief 打开串口, 不发送任何命令 \n
+   * @note 调用前需持有_serial_lock
+   */
+  result_t openPort(const char *port_path, uint32_t baudrate);
+
+  /*!
+   * @brief 快速恢复扫描 \n
+   * 重新打开串口后, 在若干个数据包时长内收到校验正确的数据包,
+   * 说明雷达仍在扫描且配置未变, 直接恢复解析, 不发送任何命令
+   * @return 返回执行结果
+   * @retval RESULT_OK       已恢复
+   * @retval RESULT_TIMEOUT  没有有效数据, 需要重新启动扫描
+   */
+  result_t resumeScan();
+
+  /*!
+   * @brief 切换电机使能引脚
+   * @param on 是否打开电机
+   */
+  void setMotorEnable(bool on);
+
+  /*!
+   * @brief 圈起始包到达时更新转速稳定判断
+   * @param now 到达时间(ns)
+   */
+  void trackMotorSpeed(uint64_t now);
+
+  /*!
+   * @brief 等待电机转速稳定, 不持有 _lock
+   * @param timeout 超时时间(ms)
+   * @return RESULT_OK 已稳定, RESULT_TIMEOUT 超时
+   */
+  result_t waitMotorReady(uint32_t timeout);
+
+  /*!
+   * @brief 丢弃串口数据, 直到一段时间内没有新数据
+   * @param timeout 最长等待时间(ms)
+   */
+  void waitSerialQuiet(uint32_t timeout);
+
   /*!
    * @brief checkAutoConnecting
    */
@@ -554,19 +991,35 @@ class YDlidarDriver {
     DEFAULT_TIMEOUT = 2000,    /**< 默认超时时间. */
     DEFAULT_HEART_BEAT = 1000, /**< 默认检测掉电功能时间. */
     MAX_SCAN_NODES = 3600,	   /**< 最大扫描点数. */
-    DEFAULT_TIMEOUT_COUNT = 1,
+    DEFAULT_TIMEOUT_COUNT = 1,  /**< 数据中断超过(本值+1)个::DEFAULT_TIMEOUT后重连. */
+    WATCHDOG_PACKAGES = 4,      /**< 数据中断超时的数据包个数. */
+    WATCHDOG_MIN_TIMEOUT = 20,  /**< 数据中断最短超时时间(ms). */
+    DEFAULT_STOP_TIMEOUT = 500, /**< 停止解析线程超时告警时间, 之后继续等待. */
+    DEFAULT_MOTOR_DELAY = 500,  /**< 无法观测转速时的电机等待时间(ms). */
+    MOTOR_READY_TIMEOUT = 500,  /**< 电机转速稳定最长等待时间(ms). */
+    MOTOR_STABLE_RINGS = 2,     /**< 判定稳定所需的连续一致圈数. */
+    MOTOR_QUIET_TIME = 50,      /**< 判定数据流已停止的静默时长(ms). */
+    DEFAULT_DETECT_TIMEOUT = 1000, /**< 自动识别串口配置最长时间(ms). */
+    DETECT_LISTEN_TIME = 40,    /**< 每个波特率下监听数据包的时间(ms). */
+    DETECT_REPLY_TIME = 30,     /**< 每个波特率下等待设备信息应答的时间(ms). */
   };
 
   node_info      *scan_node_buf;    ///< 激光点信息
   size_t         scan_node_count;   ///< 激光点数
+  ScanConsumerStats scan_stats;     ///< ::grabScanData的整圈统计
   Event          _dataEvent;        ///< 数据同步事件
+  PollEvent      _scanNotify;       ///< 整圈数据可读通知
+  PollEvent      _sectorNotify;     ///< 滚动窗口更新通知
+  PollEvent      _wakeup;           ///< 唤醒阻塞中的串口等待
+  HotplugWatcher m_hotplug;         ///< 重连时等待设备节点重新出现
+  Event          _cancelEvent;      ///< 中断重连等待, 手动复位
   Locker         _lock;				///< 线程锁
   Locker         _serial_lock;		///< 串口锁
   Thread 	     _thread;		   ///< 线程id
 
  private:
   int PackageSampleBytes;            ///< 一个包包含的激光点数
-  serial::Serial *_serial;			///< 串口
+  ChannelDevice *_comm;			///< 数据通道, 串口或URI
   bool m_intensities;				///< 信号质量状体
   uint32_t m_baudrate;				///< 波特率
   bool isSupportMotorDtrCtrl;	    ///< 是否支持电机控制
@@ -579,6 +1032,8 @@ class YDlidarDriver {
   node_packages packages;           ///< 不带信好质量协议包
 
   uint16_t package_Sample_Index;    ///< 包采样点索引
+  int package_recvPos;              ///< 当前包已接收字节数
+  uint8_t package_Sample_Num;       ///< 当前包采样点数
   float IntervalSampleAngle;
   float IntervalSampleAngle_LastPackage;
   uint16_t FirstSampleAngle;        ///< 起始采样角
@@ -613,6 +1068,30 @@ class YDlidarDriver {
   int package_index;
   bool has_package_error;
 
+  std::shared_ptr<ScanWindow> m_window; ///< 滚动360度窗口, 原子读写
+  ScanBroadcast m_broadcast;         ///< 多消费者整圈数据
+
+  node_info *local_scan;            ///< 正在拼接的一圈数据
+  size_t local_scan_count;          ///< 正在拼接的激光点数
+
+  bool seam_armed;                  ///< 接缝角检测使能
+  float seam_last_offset;           ///< 上一个点相对接缝角的偏移
+  uint8_t seam_scan_frequence;      ///< 接缝模式下最近一次转速
+
+  std::atomic<uint64_t> last_package_time;  ///< 最近一个有效数据包时间(ns)
+  std::atomic<uint8_t> max_package_samples; ///< 有效数据包最大采样点数
+  bool data_stalled;                ///< 数据中断状态
+  std::atomic<uint32_t> reconnect_count; ///< 自动重连成功次数
+  StallCallback m_stallCallback;    ///< 数据中断回调
+
+  uint64_t last_ring_time;          ///< 最近一个圈起始包时间(ns)
+  uint64_t ring_interval;           ///< 最近一圈时长(ns)
+  uint8_t ring_frequence;           ///< 最近一圈协议中的转速
+  uint8_t stable_rings;             ///< 连续一致的圈数
+  std::atomic<bool> motor_ready;    ///< 电机转速已稳定
+  std::atomic<bool> scan_paused;    ///< ::pauseScan 中, 消费者队列保持打开
+  Event motor_event;                ///< 转速稳定通知, 手动复位
+
 };
 
 }// namespace ydlidar
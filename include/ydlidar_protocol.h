@@ -259,6 +259,20 @@ struct LaserDebug {
   uint8_t     MaxDebugIndex;
 };
 
+//! A struct for returning the serial configuration detected on a port
+struct LidarDetectInfo {
+  //! Baudrate the LiDAR talks at
+  uint32_t baudrate;
+  //! LiDAR has no command channel and never answers with 0xA5 0x5A
+  bool single_channel;
+  //! Packages carry a signal quality byte per sample
+  bool intensities;
+  //! LiDAR type, see LidarTypeID
+  int lidar_type;
+  //! LiDAR model, -1 if the LiDAR cannot report it
+  int model;
+};
+
 //! A struct for returning configuration from the YDLIDAR
 struct LaserConfig {
   //! Start angle for the laser scan [rad].  0 is forward and angles are measured clockwise when viewing YDLIDAR from the top.
@@ -275,6 +289,8 @@ struct LaserConfig {
   float min_range;
   //! Maximum range [m]
   float max_range;
+  //! Configuration generation, changes with every live reconfiguration
+  uint32_t generation;
   LaserConfig &operator = (const LaserConfig &data) {
     min_angle = data.min_angle;
     max_angle = data.max_angle;
@@ -283,6 +299,7 @@ struct LaserConfig {
     scan_time = data.scan_time;
     min_range = data.min_range;
     max_range = data.max_range;
+    generation = data.generation;
     return *this;
   }
 };
@@ -0,0 +1,398 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * CPU usage versus device count, one thread per LiDAR against LidarManager.
+ * Every LiDAR is simulated on a pseudo terminal as an X4 streaming 5K samples
+ * at 10Hz, so no hardware is needed.
+ *
+ * usage: lidar_manager_bench [max devices(8)] [seconds(5)] [workers(1)]
+ */
+#include "CYdLidar.h"
+#include "lidar_manager.h"
+#include "timer.h"
+#include <atomic>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace ydlidar;
+
+namespace {
+
+const int kSamplesPerPackage = 50;
+const int kPackagesPerScan   = 10;
+const int kTickMs            = 10;
+
+/// Answers the handshake of one simulated X4 and streams scan packages.
+struct SimLidar {
+  int master;
+  std::string port;
+  bool streaming;
+  int state;          ///< command parser: 0 sync, 1 command
+  int package;
+  std::vector<uint8_t> out;
+
+  SimLidar(): master(-1), streaming(false), state(0), package(0) {}
+
+  bool open() {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+      return false;
+    }
+
+    port = ptsname(master);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return true;
+  }
+
+  void reply(const uint8_t *data, size_t size) {
+    out.insert(out.end(), data, data + size);
+  }
+
+  void handleCommand(uint8_t cmd) {
+    switch (cmd) {
+      case LIDAR_CMD_GET_DEVICE_HEALTH: {
+        const uint8_t ans[] = {0xA5, 0x5A, 0x03, 0x00, 0x00, 0x00, 0x06, 0, 0, 0};
+        reply(ans, sizeof(ans));
+      }
+      break;
+
+      case LIDAR_CMD_GET_DEVICE_INFO: {
+        const uint8_t ans[] = {0xA5, 0x5A, 0x14, 0x00, 0x00, 0x00, 0x04,
+                               YDLIDAR_X4, 0x04, 0x01, 0x01,
+                               2, 0, 2, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1
+                              };
+        reply(ans, sizeof(ans));
+      }
+      break;
+
+      case LIDAR_CMD_SCAN:
+      case LIDAR_CMD_FORCE_SCAN: {
+        const uint8_t ans[] = {0xA5, 0x5A, 0x05, 0x00, 0x00, 0x40, 0x81};
+        reply(ans, sizeof(ans));
+        streaming = true;
+        package = 0;
+      }
+      break;
+
+      case LIDAR_CMD_STOP:
+      case LIDAR_CMD_FORCE_STOP:
+        streaming = false;
+        out.clear();
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  void readCommands() {
+    uint8_t buffer[256];
+    ssize_t size;
+
+    while ((size = read(master, buffer, sizeof(buffer))) > 0) {
+      for (ssize_t i = 0; i < size; i++) {
+        uint8_t byte = buffer[i];
+
+        switch (state) {
+          case 0:
+            if (byte == LIDAR_CMD_SYNC_BYTE) {
+              state = 1;
+            }
+
+            break;
+
+          default:
+            handleCommand(byte);
+            state = 0;
+            break;
+        }
+      }
+    }
+  }
+
+  void appendPackage(bool ringStart, int count, int first) {
+    uint16_t ct = ringStart ? (0x01 | (100 << 1)) : 0x00;
+    uint16_t fsa = ((first * 64) << 1) | 0x01;
+    uint16_t lsa = (((first + (count - 1) * 360 / (kPackagesPerScan *
+                      kSamplesPerPackage)) * 64) << 1) | 0x01;
+    uint16_t cs = PH ^ fsa ^ lsa ^ (ct | (count << 8));
+    std::vector<uint16_t> samples(count);
+
+    for (int i = 0; i < count; i++) {
+      samples[i] = static_cast<uint16_t>((2000 + i) << 2);
+      cs ^= samples[i];
+    }
+
+    const uint8_t header[] = {PH & 0xFF, PH >> 8, static_cast<uint8_t>(ct),
+                              static_cast<uint8_t>(count),
+                              static_cast<uint8_t>(fsa), static_cast<uint8_t>(fsa >> 8),
+                              static_cast<uint8_t>(lsa), static_cast<uint8_t>(lsa >> 8),
+                              static_cast<uint8_t>(cs), static_cast<uint8_t>(cs >> 8)
+                             };
+    reply(header, sizeof(header));
+
+    for (int i = 0; i < count; i++) {
+      out.push_back(samples[i] & 0xFF);
+      out.push_back(samples[i] >> 8);
+    }
+  }
+
+  void tick() {
+    readCommands();
+
+    if (streaming) {
+      if (package == 0) {
+        appendPackage(true, 1, 0);
+      }
+
+      appendPackage(false, kSamplesPerPackage, package * 360 / kPackagesPerScan);
+      package = (package + 1) % kPackagesPerScan;
+    }
+
+    if (!out.empty()) {
+      ssize_t size = write(master, out.data(), out.size());
+
+      if (size > 0) {
+        out.erase(out.begin(), out.begin() + size);
+      }
+    }
+  }
+};
+
+double threadCpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+double processCpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/// Runs every simulated LiDAR from one thread and tracks its own CPU time.
+class Simulator {
+ public:
+  explicit Simulator(int count): m_lidars(count), m_running(true), m_cpu(0) {
+    for (size_t i = 0; i < m_lidars.size(); i++) {
+      m_lidars[i].open();
+    }
+
+    m_thread = std::thread([this]() {
+      while (m_running) {
+        for (size_t i = 0; i < m_lidars.size(); i++) {
+          m_lidars[i].tick();
+        }
+
+        m_cpu = threadCpuTime();
+        delay(kTickMs);
+      }
+    });
+  }
+
+  ~Simulator() {
+    m_running = false;
+    m_thread.join();
+
+    for (size_t i = 0; i < m_lidars.size(); i++) {
+      close(m_lidars[i].master);
+    }
+  }
+
+  std::string port(int i) const {
+    return m_lidars[i].port;
+  }
+
+  double cpu() const {
+    return m_cpu;
+  }
+
+ private:
+  std::vector<SimLidar> m_lidars;
+  std::atomic<bool> m_running;
+  std::atomic<double> m_cpu;
+  std::thread m_thread;
+};
+
+CYdLidar *createLidar(const std::string &port) {
+  CYdLidar *lidar = new CYdLidar();
+  lidar->setSerialPort(port);
+  lidar->setSerialBaudrate(128000);
+  lidar->setLidarType(TYPE_TRIANGLE);
+  lidar->setSingleChannel(false);
+  lidar->setSampleRate(5);
+  lidar->setScanFrequency(10);
+  lidar->setAutoReconnect(false);
+  return lidar;
+}
+
+struct Result {
+  double cpu;
+  double scans;
+};
+
+/// CPU of everything but the simulator, in percent of one core.
+Result measure(const Simulator &sim, const std::vector<std::atomic<int> *> &scans,
+               int seconds) {
+  delay(1000);
+  double cpu0 = processCpuTime() - sim.cpu();
+  int scans0 = 0;
+
+  for (size_t i = 0; i < scans.size(); i++) {
+    scans0 += *scans[i];
+  }
+
+  delay(seconds * 1000);
+  double cpu1 = processCpuTime() - sim.cpu();
+  int scans1 = 0;
+
+  for (size_t i = 0; i < scans.size(); i++) {
+    scans1 += *scans[i];
+  }
+
+  Result result;
+  result.cpu = 100.0 * (cpu1 - cpu0) / seconds;
+  result.scans = 1.0 * (scans1 - scans0) / seconds;
+  return result;
+}
+
+Result runThreaded(int count, int seconds) {
+  Simulator sim(count);
+  std::vector<CYdLidar *> lidars;
+  std::vector<std::atomic<int> *> scans;
+  std::vector<std::thread> consumers;
+  std::atomic<bool> running(true);
+
+  for (int i = 0; i < count; i++) {
+    lidars.push_back(createLidar(sim.port(i)));
+    scans.push_back(new std::atomic<int>(0));
+
+    if (!lidars[i]->initialize() || !lidars[i]->turnOn()) {
+      fprintf(stderr, "failed to start simulated LiDAR %d\n", i);
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    CYdLidar *lidar = lidars[i];
+    std::atomic<int> *counter = scans[i];
+    consumers.push_back(std::thread([lidar, counter, &running]() {
+      LaserScan scan;
+      bool hardwareError;
+
+      while (running) {
+        if (lidar->doProcessSimple(scan, hardwareError)) {
+          (*counter)++;
+        }
+      }
+    }));
+  }
+
+  Result result = measure(sim, scans, seconds);
+  running = false;
+
+  for (int i = 0; i < count; i++) {
+    consumers[i].join();
+    lidars[i]->turnOff();
+    lidars[i]->disconnecting();
+    delete lidars[i];
+    delete scans[i];
+  }
+
+  return result;
+}
+
+Result runManager(int count, int seconds, int workers) {
+  Simulator sim(count);
+  LidarManager manager(workers);
+  std::vector<std::atomic<int> *> scans;
+
+  for (int i = 0; i < count; i++) {
+    manager.addLidar(createLidar(sim.port(i)));
+    scans.push_back(new std::atomic<int>(0));
+  }
+
+  manager.setScanCallback([&scans](int id, const LaserScan & scan) {
+    UNUSED(scan);
+    (*scans[id])++;
+  });
+
+  if (!manager.start()) {
+    fprintf(stderr, "failed to start some simulated LiDARs\n");
+  }
+
+  Result result = measure(sim, scans, seconds);
+  manager.stop();
+
+  for (int i = 0; i < count; i++) {
+    delete scans[i];
+  }
+
+  return result;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  int max_devices = argc > 1 ? atoi(argv[1]) : 8;
+  int seconds = argc > 2 ? atoi(argv[2]) : 5;
+  int workers = argc > 3 ? atoi(argv[3]) : 1;
+  std::vector<int> counts;
+  std::vector<Result> threaded;
+  std::vector<Result> managed;
+
+  ydlidar::init(argc, argv);
+
+  for (int count = 1; count <= max_devices && ydlidar::ok(); count *= 2) {
+    counts.push_back(count);
+    threaded.push_back(runThreaded(count, seconds));
+    managed.push_back(runManager(count, seconds, workers));
+  }
+
+  printf("\n%8s | %12s %10s | %12s %10s\n", "devices", "threads CPU%",
+         "scans/s", "manager CPU%", "scans/s");
+
+  for (size_t i = 0; i < counts.size(); i++) {
+    printf("%8d | %12.1f %10.1f | %12.1f %10.1f\n", counts[i], threaded[i].cpu,
+           threaded[i].scans, managed[i].cpu, managed[i].scans);
+  }
+
+  return 0;
+}
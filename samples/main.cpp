@@ -96,67 +96,85 @@ int main(int argc, char *argv[]) {
   }
 
   int baudrate = 230400;
-  std::map<int, int> baudrateList;
-  baudrateList[0] = 115200;
-  baudrateList[1] = 128000;
-  baudrateList[2] = 153600;
-  baudrateList[3] = 230400;
-  baudrateList[4] = 512000;
-
-  printf("Baudrate:\n");
-
-  for (std::map<int, int>::iterator it = baudrateList.begin();
-       it != baudrateList.end(); it++) {
-    printf("%d. %d\n", it->first, it->second);
-  }
+  bool isSingleChannel = false;
+  bool isTOFLidar = false;
+  LidarDetectInfo detected;
+  //<! identify the lidar from its data stream, ask only if that fails
+  bool isDetected = IS_OK(YDlidarDriver::detectLidar(port, detected));
+
+  if (isDetected) {
+    baudrate = detected.baudrate;
+    isSingleChannel = detected.single_channel;
+    isTOFLidar = detected.lidar_type == TYPE_TOF;
+    printf("Detected %s lidar[%s] at baudrate %d\n",
+           isSingleChannel ? "one-way communication" : "two-way communication",
+           detected.model < 0 ? "unknown" : lidarModelToString(detected.model).c_str(),
+           baudrate);
+    fflush(stdout);
+  } else {
+    std::map<int, int> baudrateList;
+    baudrateList[0] = 115200;
+    baudrateList[1] = 128000;
+    baudrateList[2] = 153600;
+    baudrateList[3] = 230400;
+    baudrateList[4] = 512000;
+
+    printf("Baudrate:\n");
+
+    for (std::map<int, int>::iterator it = baudrateList.begin();
+         it != baudrateList.end(); it++) {
+      printf("%d. %d\n", it->first, it->second);
+    }
 
-  while (ydlidar::ok()) {
-    printf("Please select the lidar baudrate:");
-    std::string number;
-    std::cin >> number;
+    while (ydlidar::ok()) {
+      printf("Please select the lidar baudrate:");
+      std::string number;
+      std::cin >> number;
 
-    if ((size_t)atoi(number.c_str()) > baudrateList.size()) {
-      continue;
-    }
+      if ((size_t)atoi(number.c_str()) > baudrateList.size()) {
+        continue;
+      }
 
-    baudrate = baudrateList[atoi(number.c_str())];
-    break;
-  }
+      baudrate = baudrateList[atoi(number.c_str())];
+      break;
+    }
 
-  if (!ydlidar::ok()) {
-    return 0;
-  }
+    if (!ydlidar::ok()) {
+      return 0;
+    }
 
-  bool isSingleChannel = false;
-  bool isTOFLidar = false;
-  std::string input_channel;
-  std::string input_tof;
-  printf("Whether the Lidar is one-way communication[yes/no]:");
-  std::cin >> input_channel;
-  std::transform(input_channel.begin(), input_channel.end(),
-                 input_channel.begin(),
-  [](unsigned char c) {
-    return std::tolower(c);  // correct
-  });
-
-  if (input_channel.find("yes") != std::string::npos) {
-    isSingleChannel = true;
+    std::string input_channel;
+    printf("Whether the Lidar is one-way communication[yes/no]:");
+    std::cin >> input_channel;
+    std::transform(input_channel.begin(), input_channel.end(),
+                   input_channel.begin(),
+    [](unsigned char c) {
+      return std::tolower(c);  // correct
+    });
+
+    if (input_channel.find("yes") != std::string::npos) {
+      isSingleChannel = true;
+    }
   }
 
   if (!ydlidar::ok()) {
     return 0;
   }
 
-  printf("Whether the Lidar is a TOF Lidar [yes/no]:");
-  std::cin >> input_tof;
-  std::transform(input_tof.begin(), input_tof.end(),
-                 input_tof.begin(),
-  [](unsigned char c) {
-    return std::tolower(c);  // correct
-  });
-
-  if (input_tof.find("yes") != std::string::npos) {
-    isTOFLidar = true;
+  //<! a one-way lidar cannot report its model
+  if (!isDetected || isSingleChannel) {
+    std::string input_tof;
+    printf("Whether the Lidar is a TOF Lidar [yes/no]:");
+    std::cin >> input_tof;
+    std::transform(input_tof.begin(), input_tof.end(),
+                   input_tof.begin(),
+    [](unsigned char c) {
+      return std::tolower(c);  // correct
+    });
+
+    if (input_tof.find("yes") != std::string::npos) {
+      isTOFLidar = true;
+    }
   }
 
   if (!ydlidar::ok()) {
@@ -33,6 +33,7 @@
 *********************************************************************/
 #include "CYdLidar.h"
 #include "common.h"
+#include "lidar_identity.h"
 #include <map>
 #include <angles.h>
 #include <numeric>
@@ -42,6 +43,88 @@ using namespace ydlidar;
 using namespace impl;
 using namespace angles;
 
+//ports in use by the CYdLidar instances of this process. Probing for a serial
+//number must not talk to a LiDAR another instance runs or probes.
+enum PortState {
+  PORT_FREE,
+  PORT_PROBING,
+  PORT_CONNECTED,
+};
+
+static Locker s_portLock;
+static std::map<std::string, PortState> s_ports;
+
+/*!
+ * @brief registers a port as in use, a connection takes it over regardless
+ * @return previous state, PORT_FREE if the port was claimed
+ */
+static PortState claimPort(const std::string &port, PortState state) {
+  ScopedLocker l(s_portLock);
+  std::map<std::string, PortState>::iterator it = s_ports.find(port);
+  PortState previous = it == s_ports.end() ? PORT_FREE : it->second;
+
+  if (previous == PORT_FREE || state == PORT_CONNECTED) {
+    s_ports[port] = state;
+  }
+
+  return previous;
+}
+
+static void releasePort(const std::string &port) {
+  ScopedLocker l(s_portLock);
+  s_ports.erase(port);
+}
+
+//one device, whatever link or prefix names it.
+static std::string canonicalPort(const std::string &port) {
+#if defined(__linux__)
+  char *path = realpath(port.c_str(), NULL);
+
+  if (path) {
+    std::string canonical(path);
+    free(path);
+    return canonical;
+  }
+
+#else
+
+  if (port.compare(0, 4, "\\\\.\\") == 0) {
+    return port.substr(4);
+  }
+
+#endif
+  return port;
+}
+
+//keeps an event loop out of CYdLidar::processReadable while the calling
+//thread talks to the LiDAR; the driver reads the port from this thread
+//meanwhile instead of waiting for the blocked loop.
+class PortExchange {
+ public:
+  PortExchange(Locker &lock, YDlidarDriver *driver,
+               const std::atomic<bool> &external)
+    : m_lock(lock), m_driver(driver), m_external(external) {
+    m_lock.lock();
+
+    if (m_driver) {
+      m_driver->setExternalLoop(false);
+    }
+  }
+
+  ~PortExchange() {
+    if (m_driver) {
+      m_driver->setExternalLoop(m_external);
+    }
+
+    m_lock.unlock();
+  }
+
+ private:
+  Locker &m_lock;
+  YDlidarDriver *m_driver;
+  const std::atomic<bool> &m_external;
+};
+
 
 /*-------------------------------------------------------------
 						Constructor
@@ -70,19 +153,40 @@ CYdLidar::CYdLidar(): lidarPtr(nullptr) {
   Major               = 0;
   Minjor              = 0;
   m_IgnoreArray.clear();
+  m_ScanSeamAngle     = 360.f;
+  m_ScanWindowBins    = 0;
+  m_ScanHistoryDuration = 0.f;
+  m_reconnectCount    = 0;
+  m_revalidateScans   = 0;
+  m_revalidateFailures = 0;
+  m_scanPoints        = 0.f;
+  m_ProfileCacheDir   = "";
+  m_FastStart         = false;
+  m_DeviceSerialNumber = "";
+  m_UserScanFrequency = 10;
+  m_profileLoaded     = false;
+  m_profileTrusted    = false;
+  m_standby           = false;
+  m_lowPower          = false;
+  m_reconfiguring     = false;
+  m_Threadless        = false;
+  m_ExternalLoop      = false;
   m_PointTime         = 1e9 / 5000;
   m_OffsetTime        = 0.0;
   m_AngleOffset       = 0.0;
+  m_isAngleOffsetCorrected = false;
   lidar_model = YDLIDAR_G2B;
   last_node_time = getTime();
   global_nodes = new node_info[YDlidarDriver::MAX_SCAN_NODES];
   m_ParseSuccess = false;
+  updateFilter(true);
 }
 
 /*-------------------------------------------------------------
                     ~CYdLidar
 -------------------------------------------------------------*/
 CYdLidar::~CYdLidar() {
+  waitAsync();
   disconnecting();
 
   if (global_nodes) {
@@ -98,6 +202,11 @@ void CYdLidar::disconnecting() {
     lidarPtr = nullptr;
   }
 
+  if (!m_claimedPort.empty()) {
+    releasePort(m_claimedPort);
+    m_claimedPort.clear();
+  }
+
   isScanning = false;
 }
 
@@ -122,20 +231,48 @@ std::string CYdLidar::getSerialNumber() const {
   return m_lidarSerialNum;
 }
 
-bool CYdLidar::isRangeValid(double reading) const {
-  if (reading >= m_MinRange && reading <= m_MaxRange) {
+std::shared_ptr<const CYdLidar::ScanFilter> CYdLidar::currentFilter() const {
+  ScopedLocker l(m_filterLock);
+  return m_filter;
+}
+
+void CYdLidar::updateFilter(bool force) {
+  ScopedLocker l(m_filterLock);
+
+  if (m_MaxAngle < m_MinAngle) {
+    std::swap(m_MinAngle, m_MaxAngle);
+  }
+
+  if (!force && m_filter && m_filter->min_range == m_MinRange &&
+      m_filter->max_range == m_MaxRange && m_filter->min_angle == m_MinAngle &&
+      m_filter->max_angle == m_MaxAngle && m_filter->ignore == m_IgnoreArray) {
+    return;
+  }
+
+  std::shared_ptr<ScanFilter> filter = std::make_shared<ScanFilter>();
+  filter->min_range = m_MinRange;
+  filter->max_range = m_MaxRange;
+  filter->min_angle = m_MinAngle;
+  filter->max_angle = m_MaxAngle;
+  filter->ignore = m_IgnoreArray;
+  filter->generation = m_filter ? m_filter->generation + 1 : 0;
+  m_filter = filter;
+}
+
+bool CYdLidar::isRangeValid(const ScanFilter &filter, double reading) const {
+  if (reading >= filter.min_range && reading <= filter.max_range) {
     return true;
   }
 
   return false;
 }
 
-bool CYdLidar::isRangeIgnore(double angle) const {
+bool CYdLidar::isRangeIgnore(const ScanFilter &filter, double angle) const {
   bool ret = false;
 
-  for (uint16_t j = 0; j < m_IgnoreArray.size(); j = j + 2) {
-    if ((angles::from_degrees(m_IgnoreArray[j]) <= angle) &&
-        (angle <= angles::from_degrees(m_IgnoreArray[j + 1]))) {
+  for (uint16_t j = 0; j + 1 < filter.ignore.size(); j = j + 2) {
+    if ((angles::from_degrees(filter.ignore[j]) <= angle) &&
+        (angle <= angles::from_degrees(filter.ignore[j + 1]))) {
       ret = true;
       break;
     }
@@ -144,6 +281,30 @@ bool CYdLidar::isRangeIgnore(double angle) const {
   return ret;
 }
 
+float CYdLidar::lidarScanSeamAngle() const {
+  if (m_ScanSeamAngle < -180.f || m_ScanSeamAngle > 180.f) {
+    return -1.f;
+  }
+
+  //inverse of the angle transform in doProcessSimple
+  float angle = m_ScanSeamAngle;
+
+  if (m_Inverted) {
+    angle = 360.f - angle;
+  }
+
+  if (m_Reversion) {
+    angle -= 180.f;
+  }
+
+  angle = fmod(angle - m_AngleOffset, 360.f);
+
+  if (angle < 0.f) {
+    angle += 360.f;
+  }
+
+  return angle;
+}
 
 /*-------------------------------------------------------------
 						doProcessSimple
@@ -152,10 +313,23 @@ bool  CYdLidar::doProcessSimple(LaserScan &outscan,
                                 bool &hardwareError) {
   hardwareError			= false;
 
+  //an external loop serves other LiDARs too, it must never sleep here.
+  if (m_standby || m_reconfiguring) {
+    if (!m_ExternalLoop) {
+      delay(200 / m_ScanFrequency);
+    }
+
+    return false;
+  }
+
   // Bound?
   if (!checkHardware()) {
     hardwareError = true;
-    delay(200 / m_ScanFrequency);
+
+    if (!m_ExternalLoop) {
+      delay(200 / m_ScanFrequency);
+    }
+
     return false;
   }
 
@@ -186,117 +360,498 @@ bool  CYdLidar::doProcessSimple(LaserScan &outscan,
 
     last_node_time = tim_scan_end;
 
-    if (m_MaxAngle < m_MinAngle) {
-      float temp = m_MinAngle;
-      m_MinAngle = m_MaxAngle;
-      m_MaxAngle = temp;
+    //properties set directly apply from the next scan on.
+    updateFilter(false);
+    fillScan(global_nodes, count, tim_scan_start, outscan);
+    handleDeviceInfoPackage(count);
+
+    if (!checkIdentity()) {
+      //single channel LiDARs tell who they are only now.
+      dropIdentity();
+      turnOff();
+      hardwareError = true;
+      return false;
     }
 
-    int all_node_count = count;
+    if (!revalidateProfile(count)) {
+      //the cached state no longer holds, the caller has to initialize again.
+      if (m_profileTrusted) {
+        dropProfile();
+      }
 
-    outscan.config.min_angle = angles::from_degrees(m_MinAngle);
-    outscan.config.max_angle =  angles::from_degrees(m_MaxAngle);
-    outscan.config.scan_time =  static_cast<float>(scan_time * 1.0 / 1e9);
-    outscan.config.time_increment = outscan.config.scan_time / (double)(count - 1);
-    outscan.config.min_range = m_MinRange;
-    outscan.config.max_range = m_MaxRange;
-    outscan.stamp = tim_scan_start;
-    outscan.points.clear();
+      turnOff();
+      hardwareError = true;
+      return false;
+    }
 
-    if (m_FixedResolution) {
-      all_node_count = m_FixedSize;
+    if (m_history.duration()) {
+      m_history.push(std::make_shared<LaserScan>(outscan));
     }
 
-    outscan.config.angle_increment = (outscan.config.max_angle -
-                                      outscan.config.min_angle) / (all_node_count - 1);
+    return true;
+  } else {
+    if (IS_FAIL(op_result)) {
+      // Error? Retry connection
+    }
+  }
+
+  return false;
+
+}
+
+void CYdLidar::fillScan(const node_info *nodes, size_t count,
+                        uint64_t tim_scan_start, LaserScan &outscan) const {
+  int all_node_count = count;
+  //one filter for the whole scan, whatever reconfigure does meanwhile.
+  std::shared_ptr<const ScanFilter> filter = currentFilter();
+
+  outscan.config.min_angle = angles::from_degrees(std::min(filter->min_angle,
+                           filter->max_angle));
+  outscan.config.max_angle = angles::from_degrees(std::max(filter->min_angle,
+                           filter->max_angle));
+  uint64_t scan_time = m_PointTime * (count - 1);
+  outscan.config.scan_time =  static_cast<float>(scan_time * 1.0 / 1e9);
+  outscan.config.time_increment = outscan.config.scan_time / (double)(count - 1);
+  outscan.config.min_range = filter->min_range;
+  outscan.config.max_range = filter->max_range;
+  outscan.config.generation = filter->generation;
+  outscan.stamp = tim_scan_start;
+  outscan.points.clear();
+
+  if (m_FixedResolution) {
+    all_node_count = m_FixedSize;
+  }
+
+  outscan.config.angle_increment = (outscan.config.max_angle -
+                                    outscan.config.min_angle) / (all_node_count - 1);
 
-    float range = 0.0;
-    float intensity = 0.0;
-    float angle = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    LaserPoint point;
+    nodeToPoint(nodes[i], *filter, point);
+    float angle = point.angle;
 
-    for (int i = 0; i < count; i++) {
-      angle = static_cast<float>((global_nodes[i].angle_q6_checkbit >>
-                                  LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT) / 64.0f) + m_AngleOffset;
+    if (angle >= outscan.config.min_angle &&
+        angle <= outscan.config.max_angle) {
+      if (outscan.points.empty()) {
+        outscan.stamp = tim_scan_start + i * m_PointTime;
+      }
 
-      if (isTOFLidar(m_LidarType)) {
-        if (isOldVersionTOFLidar(lidar_model, Major, Minjor)) {
-          range = static_cast<float>(global_nodes[i].distance_q2 / 2000.f);
-        } else {
-          range = static_cast<float>(global_nodes[i].distance_q2 / 1000.f);
+      if (m_FixedResolution) {
+        int index = std::ceil((angle - outscan.config.min_angle) /
+                              outscan.config.angle_increment);
+
+        if (index >= 0 && index < all_node_count) {
+          outscan.points.push_back(point);
         }
       } else {
-        if (isOctaveLidar(lidar_model)) {
-          range = static_cast<float>(global_nodes[i].distance_q2 / 2000.f);
-        } else {
-          range = static_cast<float>(global_nodes[i].distance_q2 / 4000.f);
-        }
+        outscan.points.push_back(point);
       }
+    }
+  }
 
-      intensity = static_cast<float>(global_nodes[i].sync_quality);
-      angle = angles::from_degrees(angle);
+  if (m_FixedResolution) {
+    outscan.points.resize(all_node_count);
+  }
+}
 
-      //Rotate 180 degrees or not
-      if (m_Reversion) {
-        angle = angle + M_PI;
-      }
+void CYdLidar::nodeToPoint(const node_info &node, const ScanFilter &filter,
+                           LaserPoint &point) const {
+  float range = 0.0;
+  float intensity = 0.0;
+  float angle = static_cast<float>((node.angle_q6_checkbit >>
+                                    LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT) / 64.0f) + m_AngleOffset;
 
-      //Is it counter clockwise
-      if (m_Inverted) {
-        angle = 2 * M_PI - angle;
-      }
+  if (isTOFLidar(m_LidarType)) {
+    if (isOldVersionTOFLidar(lidar_model, Major, Minjor)) {
+      range = static_cast<float>(node.distance_q2 / 2000.f);
+    } else {
+      range = static_cast<float>(node.distance_q2 / 1000.f);
+    }
+  } else {
+    if (isOctaveLidar(lidar_model)) {
+      range = static_cast<float>(node.distance_q2 / 2000.f);
+    } else {
+      range = static_cast<float>(node.distance_q2 / 4000.f);
+    }
+  }
 
-      angle = angles::normalize_angle(angle);
+  intensity = static_cast<float>(node.sync_quality);
+  angle = angles::from_degrees(angle);
 
-      //ignore angle
-      if (isRangeIgnore(angle)) {
-        range = 0.0;
-      }
+  //Rotate 180 degrees or not
+  if (m_Reversion) {
+    angle = angle + M_PI;
+  }
 
-      //valid range
-      if (!isRangeValid(range)) {
-        range = 0.0;
-        intensity = 0.0;
-      }
+  //Is it counter clockwise
+  if (m_Inverted) {
+    angle = 2 * M_PI - angle;
+  }
 
-      if (angle >= outscan.config.min_angle &&
-          angle <= outscan.config.max_angle) {
-        LaserPoint point;
-        point.angle = angle;
-        point.range = range;
-        point.intensity = intensity;
+  angle = angles::normalize_angle(angle);
 
-        if (outscan.points.empty()) {
-          outscan.stamp = tim_scan_start + i * m_PointTime;
-        }
+  //ignore angle
+  if (isRangeIgnore(filter, angle)) {
+    range = 0.0;
+  }
 
-        if (m_FixedResolution) {
-          int index = std::ceil((angle - outscan.config.min_angle) /
-                                outscan.config.angle_increment);
+  //valid range
+  if (!isRangeValid(filter, range)) {
+    range = 0.0;
+    intensity = 0.0;
+  }
 
-          if (index >= 0 && index < all_node_count) {
-            outscan.points.push_back(point);
-          }
-        } else {
-          outscan.points.push_back(point);
-        }
-      }
+  point.angle = angle;
+  point.range = range;
+  point.intensity = intensity;
+}
+
+/*-------------------------------------------------------------
+                        getScanWindow
+-------------------------------------------------------------*/
+bool CYdLidar::getScanWindow(LaserScan &outscan, std::vector<float> &ages) {
+  std::vector<ScanWindowBin> window_bins;
+
+  if (!lidarPtr || !IS_OK(lidarPtr->getScanWindow(window_bins))) {
+    return false;
+  }
+
+  std::shared_ptr<const ScanFilter> filter = currentFilter();
+  outscan.points.clear();
+  ages.clear();
+  outscan.stamp = getTime();
+  outscan.config.min_angle = angles::from_degrees(std::min(filter->min_angle,
+                             filter->max_angle));
+  outscan.config.max_angle = angles::from_degrees(std::max(filter->min_angle,
+                             filter->max_angle));
+  outscan.config.angle_increment = 2 * M_PI / window_bins.size();
+  outscan.config.scan_time = 1.0 / m_ScanFrequency;
+  outscan.config.time_increment = m_PointTime / 1e9;
+  outscan.config.min_range = filter->min_range;
+  outscan.config.max_range = filter->max_range;
+  outscan.config.generation = filter->generation;
+
+  node_info node;
+  memset(&node, 0, sizeof(node));
+
+  for (size_t i = 0; i < window_bins.size(); i++) {
+    const ScanWindowBin &bin = window_bins[i];
+
+    if (bin.stamp == 0) {
+      continue;
     }
 
-    if (m_FixedResolution) {
-      outscan.points.resize(all_node_count);
+    node.sync_quality = bin.sync_quality;
+    node.angle_q6_checkbit = bin.angle_q6_checkbit;
+    node.distance_q2 = bin.distance_q2;
+    LaserPoint point;
+    nodeToPoint(node, *filter, point);
+
+    if (point.angle >= outscan.config.min_angle &&
+        point.angle <= outscan.config.max_angle) {
+      outscan.points.push_back(point);
+      ages.push_back(static_cast<float>(bin.age / 1e9));
     }
+  }
 
-    handleDeviceInfoPackage(count);
+  return true;
+}
 
-    return true;
-  } else {
-    if (IS_FAIL(op_result)) {
-      // Error? Retry connection
+/*-------------------------------------------------------------
+                        addScanConsumer
+-------------------------------------------------------------*/
+int CYdLidar::addScanConsumer(OverrunPolicy policy, uint32_t block_ms,
+                              size_t depth) {
+  if (!lidarPtr) {
+    return -1;
+  }
+
+  return lidarPtr->addScanConsumer(policy, block_ms, depth);
+}
+
+/*-------------------------------------------------------------
+                        removeScanConsumer
+-------------------------------------------------------------*/
+void CYdLidar::removeScanConsumer(int consumer) {
+  if (lidarPtr) {
+    lidarPtr->removeScanConsumer(consumer);
+  }
+}
+
+/*-------------------------------------------------------------
+                        grabScanFrame
+-------------------------------------------------------------*/
+bool CYdLidar::grabScanFrame(int consumer,
+                             std::shared_ptr<const ScanFrame> &frame,
+                             uint64_t *lost, uint32_t timeout) {
+  if (!lidarPtr) {
+    return false;
+  }
+
+  return IS_OK(lidarPtr->grabScanFrame(consumer, frame, timeout, lost));
+}
+
+/*-------------------------------------------------------------
+                        grabScan
+-------------------------------------------------------------*/
+bool CYdLidar::grabScan(int consumer, LaserScan &outscan, uint64_t *seq,
+                        uint64_t *lost, uint32_t timeout) {
+  std::shared_ptr<const ScanFrame> frame;
+
+  if (!grabScanFrame(consumer, frame, lost, timeout)) {
+    return false;
+  }
+
+  frameToScan(*frame, outscan);
+
+  if (seq) {
+    *seq = frame->seq;
+  }
+
+  return true;
+}
+
+/*-------------------------------------------------------------
+                        grabScanFrames
+-------------------------------------------------------------*/
+bool CYdLidar::grabScanFrames(int consumer,
+                              std::vector<std::shared_ptr<const ScanFrame> > &frames,
+                              size_t max, uint64_t *lost, uint32_t timeout) {
+  if (!lidarPtr) {
+    return false;
+  }
+
+  return IS_OK(lidarPtr->grabScanFrames(consumer, frames, max, timeout, lost));
+}
+
+/*-------------------------------------------------------------
+                        grabScans
+-------------------------------------------------------------*/
+bool CYdLidar::grabScans(int consumer, std::vector<LaserScan> &scans,
+                         size_t max, uint64_t *lost, uint32_t timeout) {
+  std::vector<std::shared_ptr<const ScanFrame> > frames;
+
+  if (!grabScanFrames(consumer, frames, max, lost, timeout)) {
+    scans.clear();
+    return false;
+  }
+
+  scans.resize(frames.size());
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    frameToScan(*frames[i], scans[i]);
+  }
+
+  return true;
+}
+
+void CYdLidar::frameToScan(const ScanFrame &frame, LaserScan &outscan) const {
+  if (frame.nodes.empty()) {
+    outscan.stamp = frame.stamp;
+    outscan.points.clear();
+    return;
+  }
+
+  //same timing as doProcessSimple, minus the cross-scan clamping which
+  //belongs to the doProcessSimple consumer alone.
+  uint64_t tim_scan_end = frame.stamp + m_OffsetTime * 1e9;
+  tim_scan_end -= m_PointTime;
+  tim_scan_end -= frame.nodes[0].stamp;
+  fillScan(&frame.nodes[0], frame.nodes.size(),
+           tim_scan_end - m_PointTime * (frame.nodes.size() - 1), outscan);
+}
+
+/*-------------------------------------------------------------
+                        getScanStats
+-------------------------------------------------------------*/
+bool CYdLidar::getScanStats(int consumer, ScanConsumerStats &stats) {
+  if (!lidarPtr) {
+    return false;
+  }
+
+  return IS_OK(lidarPtr->getScanStats(consumer, stats));
+}
+
+/*-------------------------------------------------------------
+                        getNearestScan
+-------------------------------------------------------------*/
+ScanHistory::ScanPtr CYdLidar::getNearestScan(uint64_t t) {
+  return m_history.nearest(t);
+}
+
+/*-------------------------------------------------------------
+                        getScans
+-------------------------------------------------------------*/
+void CYdLidar::getScans(uint64_t t0, uint64_t t1,
+                        std::vector<ScanHistory::ScanPtr> &scans) {
+  m_history.range(t0, t1, scans);
+}
+
+/*-------------------------------------------------------------
+                        getRangeAt
+-------------------------------------------------------------*/
+bool CYdLidar::getRangeAt(float angle, uint64_t t, float &range) {
+  return m_history.rangeAt(angle, t, range);
+}
+
+/*-------------------------------------------------------------
+                        setStallCallback
+-------------------------------------------------------------*/
+void CYdLidar::setStallCallback(const YDlidarDriver::StallCallback &callback) {
+  m_stallCallback = callback;
+
+  if (lidarPtr) {
+    lidarPtr->setStallCallback(callback);
+  }
+}
+
+/*-------------------------------------------------------------
+                        getDataTimeout
+-------------------------------------------------------------*/
+uint32_t CYdLidar::getDataTimeout() const {
+  if (!lidarPtr) {
+    return YDlidarDriver::DEFAULT_TIMEOUT;
+  }
+
+  return lidarPtr->getDataTimeout();
+}
+
+/*-------------------------------------------------------------
+                        setProgressCallback
+-------------------------------------------------------------*/
+void CYdLidar::setProgressCallback(const ProgressCallback &callback) {
+  m_progressCallback = callback;
+}
+
+void CYdLidar::reportProgress(BringUpStage stage) {
+  if (m_progressCallback) {
+    m_progressCallback(stage);
+  }
+}
+
+/*-------------------------------------------------------------
+                        initializeAsync
+-------------------------------------------------------------*/
+std::shared_future<bool> CYdLidar::initializeAsync() {
+  std::shared_future<bool> previous = m_bringUp;
+  m_bringUp = std::async(std::launch::async, [this, previous]() {
+    if (previous.valid()) {
+      previous.wait();
     }
+
+    return initialize();
+  }).share();
+  return m_bringUp;
+}
+
+/*-------------------------------------------------------------
+                        turnOnAsync
+-------------------------------------------------------------*/
+std::shared_future<bool> CYdLidar::turnOnAsync() {
+  std::shared_future<bool> previous = m_bringUp;
+  m_bringUp = std::async(std::launch::async, [this, previous]() {
+    if (previous.valid() && !previous.get()) {
+      reportProgress(BRINGUP_FAILED);
+      return false;
+    }
+
+    return turnOn();
+  }).share();
+  return m_bringUp;
+}
+
+/*-------------------------------------------------------------
+                        waitAsync
+-------------------------------------------------------------*/
+void CYdLidar::waitAsync() {
+  if (m_bringUp.valid()) {
+    m_bringUp.wait();
   }
+}
 
-  return false;
+/*-------------------------------------------------------------
+                        checkWatchdog
+-------------------------------------------------------------*/
+bool CYdLidar::checkWatchdog() {
+  if (!lidarPtr) {
+    return false;
+  }
 
+  return lidarPtr->checkWatchdog();
+}
+
+/*-------------------------------------------------------------
+                        processReadable
+-------------------------------------------------------------*/
+bool CYdLidar::processReadable(size_t *scans) {
+  if (!lidarPtr) {
+    return false;
+  }
+
+  //standby, resume, reconfigure and turnOn/turnOff own the port until done.
+  ScopedLocker l(m_ioLock);
+
+  //parked, not failed: drop what arrives, or a level-triggered loop would
+  //wake up for it again and again.
+  if (m_standby) {
+    if (scans) {
+      *scans = 0;
+    }
+
+    return IS_OK(lidarPtr->discardReadable());
+  }
+
+  return IS_OK(lidarPtr->processReadable(scans));
+}
+
+/*-------------------------------------------------------------
+                        setExternalLoop
+-------------------------------------------------------------*/
+void CYdLidar::setExternalLoop(bool enabled) {
+  //not in the middle of a command exchange that borrowed the port.
+  ScopedLocker l(m_ioLock);
+  m_ExternalLoop = enabled;
+
+  if (lidarPtr) {
+    lidarPtr->setExternalLoop(enabled);
+  }
+}
+
+bool CYdLidar::getExternalLoop() const {
+  return m_ExternalLoop;
+}
+
+/*-------------------------------------------------------------
+                        getFileDescriptor
+-------------------------------------------------------------*/
+int CYdLidar::getFileDescriptor() {
+  if (!lidarPtr) {
+    return -1;
+  }
+
+  return lidarPtr->getFileDescriptor();
+}
+
+/*-------------------------------------------------------------
+                        getScanEventFd
+-------------------------------------------------------------*/
+int CYdLidar::getScanEventFd() const {
+  if (!lidarPtr) {
+    return -1;
+  }
+
+  return lidarPtr->getScanEventFd();
+}
+
+/*-------------------------------------------------------------
+                        getSectorEventFd
+-------------------------------------------------------------*/
+int CYdLidar::getSectorEventFd() const {
+  if (!lidarPtr) {
+    return -1;
+  }
+
+  return lidarPtr->getSectorEventFd();
 }
 
 void CYdLidar::parsePackageNode(const node_info &node, LaserDebug &info) {
@@ -349,40 +904,107 @@ void CYdLidar::handleDeviceInfoPackage(int count) {
     return;
   }
 
+  device_info info;
+  std::string serial_number;
+
+  if (parseStreamDeviceInfo(global_nodes, count, info, serial_number)) {
+    Major = (uint8_t)(info.firmware_version >> 8);
+    Minjor = (uint8_t)(info.firmware_version & 0xff);
+    std::string softVer =  std::to_string(Major & 0xff) + "." + std::to_string(
+                             Minjor & 0xff);
+    std::string hardVer = std::to_string(info.hardware_version & 0xff);
+
+    bool learned = m_lidarSerialNum != serial_number;
+    m_lidarSerialNum = serial_number;
+    m_lidarSoftVer = softVer;
+    m_lidarHardVer = hardVer;
+
+    if (!m_ParseSuccess) {
+      printfVersionInfo(info);
+    }
+
+    if (learned) {
+      saveIdentity();
+    }
+  }
+}
+
+bool CYdLidar::parseStreamDeviceInfo(const node_info *nodes, int count,
+                                     device_info &info,
+                                     std::string &serial_number) {
   LaserDebug debug;
   debug.MaxDebugIndex = 0;
 
   for (int i = 0; i < count; i++) {
-    parsePackageNode(global_nodes[i], debug);
+    parsePackageNode(nodes[i], debug);
   }
 
-  device_info info;
+  if (!ParseLaserDebugInfo(debug, info)) {
+    return false;
+  }
+
+  if (info.firmware_version == 0 &&
+      info.hardware_version == 0) {
+    return false;
+  }
 
-  if (ParseLaserDebugInfo(debug, info)) {
-    if (info.firmware_version != 0 ||
-        info.hardware_version != 0) {
-      std::string serial_number;
+  serial_number.clear();
 
-      for (int i = 0; i < 16; i++) {
-        serial_number += std::to_string(info.serialnum[i] & 0xff);
-      }
+  for (int i = 0; i < 16; i++) {
+    serial_number += std::to_string(info.serialnum[i] & 0xff);
+  }
 
-      Major = (uint8_t)(info.firmware_version >> 8);
-      Minjor = (uint8_t)(info.firmware_version & 0xff);
-      std::string softVer =  std::to_string(Major & 0xff) + "." + std::to_string(
-                               Minjor & 0xff);
-      std::string hardVer = std::to_string(info.hardware_version & 0xff);
+  return true;
+}
 
-      m_lidarSerialNum = serial_number;
-      m_lidarSoftVer = softVer;
-      m_lidarHardVer = hardVer;
+//scans checked after each reconnect or fast start, and mismatches tolerated
+//among them.
+static const int kRevalidateScans = 10;
+static const int kRevalidateFailures = 3;
 
-      if (!m_ParseSuccess) {
-        printfVersionInfo(info);
-      }
-    }
+bool CYdLidar::revalidateProfile(int count) {
+  if (m_reconnectCount != lidarPtr->getReconnectCount()) {
+    m_reconnectCount = lidarPtr->getReconnectCount();
+    m_revalidateScans = kRevalidateScans;
+    m_revalidateFailures = 0;
+  }
+
+  if (m_revalidateScans <= 0) {
+    //the stream confirmed a fast start profile.
+    m_profileTrusted = false;
+    //learn the revolution size while nothing is in doubt.
+    m_scanPoints = m_scanPoints > 0 ? 0.9f * m_scanPoints + 0.1f * count :
+                   count;
+    return true;
+  }
+
+  m_revalidateScans--;
+  device_info info;
+  std::string serial_number;
+
+  if (!m_lidarSerialNum.empty() &&
+      parseStreamDeviceInfo(global_nodes, count, info, serial_number) &&
+      serial_number != m_lidarSerialNum) {
+    fprintf(stderr, "[CYdLidar] A different LiDAR[%s] appeared on %s\n",
+            serial_number.c_str(), m_SerialPort.c_str());
+    fflush(stderr);
+    return false;
+  }
+
+  //a power cycled device falls back to its default sample rate or frequency.
+  if (m_scanPoints > 0 && fabs(count - m_scanPoints) > 0.25f * m_scanPoints) {
+    m_revalidateFailures++;
+  }
 
+  if (m_revalidateFailures >= kRevalidateFailures) {
+    fprintf(stderr,
+            "[CYdLidar] LiDAR settings changed after reconnecting, %d points per scan instead of %.0f\n",
+            count, m_scanPoints);
+    fflush(stderr);
+    return false;
   }
+
+  return true;
 }
 
 
@@ -394,28 +1016,49 @@ bool  CYdLidar::turnOn() {
     return true;
   }
 
+  PortExchange exchange(m_ioLock, lidarPtr, m_ExternalLoop);
+
+  if (m_standby) {
+    leaveStandby();
+  }
+
+  lidarPtr->setScanSeamAngle(lidarScanSeamAngle());
+  lidarPtr->setScanWindow(m_ScanWindowBins);
+  m_history.setDuration(m_ScanHistoryDuration > 0 ?
+                        static_cast<uint64_t>(m_ScanHistoryDuration * 1e9) : 0);
   // start scan...
+  reportProgress(BRINGUP_STARTING_SCAN);
   result_t op_result = lidarPtr->startScan();
 
   if (!IS_OK(op_result)) {
     op_result = lidarPtr->startScan();
+  }
 
-    if (!IS_OK(op_result)) {
-      lidarPtr->stop();
-      fprintf(stderr, "[CYdLidar] Failed to start scan mode: %x\n", op_result);
-      isScanning = false;
-      return false;
-    }
+  //an event loop keeps a parked LiDAR until its scan is restarted.
+  m_standby = false;
+
+  if (!IS_OK(op_result)) {
+    lidarPtr->stop();
+    fprintf(stderr, "[CYdLidar] Failed to start scan mode: %x\n", op_result);
+    isScanning = false;
+    reportProgress(BRINGUP_FAILED);
+    return false;
   }
 
-  m_ParseSuccess &= !m_SingleChannel;
+  m_ParseSuccess &= !m_SingleChannel || m_profileLoaded;
   m_PointTime = lidarPtr->getPointTime();
+  m_profileTrusted = m_profileLoaded;
+
+  if (!m_profileTrusted) {
+    reportProgress(BRINGUP_CHECKING_SCAN);
+  }
 
-  if (checkLidarAbnormal()) {
+  if (!m_profileTrusted && checkLidarAbnormal()) {
     lidarPtr->stop();
     fprintf(stderr,
             "[CYdLidar] Failed to turn on the Lidar, because the lidar is blocked or the lidar hardware is faulty.\n");
     isScanning = false;
+    reportProgress(BRINGUP_FAILED);
     return false;
   }
 
@@ -424,11 +1067,31 @@ bool  CYdLidar::turnOn() {
   }
 
   m_PointTime = lidarPtr->getPointTime();
+  m_reconnectCount = lidarPtr->getReconnectCount();
+  m_revalidateFailures = 0;
+
+  if (m_profileTrusted) {
+    //nothing was measured, hold the first scans against the cached profile.
+    m_revalidateScans = kRevalidateScans;
+    m_scanPoints = m_FixedSize;
+  } else {
+    //a fresh negotiation, relearn what the stream should look like.
+    m_revalidateScans = 0;
+    m_scanPoints = 0.f;
+
+    if (!m_profileLoaded) {
+      saveProfile();
+    }
+  }
+
+  saveIdentity();
+
   isScanning = true;
   lidarPtr->setAutoReconnect(m_AutoReconnect);
   printf("[YDLIDAR INFO] Current Sampling Rate : %dK\n", m_SampleRate);
   printf("[YDLIDAR INFO] Now YDLIDAR is scanning ......\n");
   fflush(stdout);
+  reportProgress(BRINGUP_SCANNING);
   return true;
 }
 
@@ -437,7 +1100,13 @@ bool  CYdLidar::turnOn() {
 -------------------------------------------------------------*/
 bool  CYdLidar::turnOff() {
   if (lidarPtr) {
+    PortExchange exchange(m_ioLock, lidarPtr, m_ExternalLoop);
     lidarPtr->stop();
+
+    if (m_standby) {
+      leaveStandby();
+      m_standby = false;
+    }
   }
 
   if (isScanning) {
@@ -448,6 +1117,192 @@ bool  CYdLidar::turnOff() {
   return true;
 }
 
+/*-------------------------------------------------------------
+						standby
+-------------------------------------------------------------*/
+bool CYdLidar::standby() {
+  //devices without the low-power commands never answer, do not wait long.
+  const uint32_t kLowPowerTimeout = 200;
+
+  if (!checkHardware()) {
+    return false;
+  }
+
+  PortExchange exchange(m_ioLock, lidarPtr, m_ExternalLoop);
+  //set first, so an event loop does not take the stop for a failure.
+  m_standby = true;
+  lidarPtr->stop();
+  isScanning = false;
+  function_state state;
+  m_lowPower = !m_SingleChannel &&
+               IS_OK(lidarPtr->enableLowPower(state, kLowPowerTimeout));
+  printf("[YDLIDAR INFO] Now YDLIDAR is in standby%s ......\n",
+         m_lowPower ? " (low power)" : "");
+  fflush(stdout);
+  return true;
+}
+
+/*-------------------------------------------------------------
+						resume
+-------------------------------------------------------------*/
+bool CYdLidar::resume() {
+  if (!m_standby || !lidarPtr) {
+    return false;
+  }
+
+  PortExchange exchange(m_ioLock, lidarPtr, m_ExternalLoop);
+  leaveStandby();
+  result_t op_result = lidarPtr->startScan();
+
+  if (!IS_OK(op_result)) {
+    op_result = lidarPtr->startScan();
+  }
+
+  m_standby = false;
+
+  if (!IS_OK(op_result)) {
+    lidarPtr->stop();
+    fprintf(stderr, "[CYdLidar] Failed to resume scanning: %x\n", op_result);
+    fflush(stderr);
+    return false;
+  }
+
+  //trust what was negotiated, but check it like after a reconnect.
+  m_reconnectCount = lidarPtr->getReconnectCount();
+  m_revalidateScans = kRevalidateScans;
+  m_revalidateFailures = 0;
+
+  if (m_scanPoints <= 0) {
+    m_scanPoints = m_FixedSize;
+  }
+
+  isScanning = true;
+  lidarPtr->setAutoReconnect(m_AutoReconnect);
+  printf("[YDLIDAR INFO] Now YDLIDAR is scanning ......\n");
+  fflush(stdout);
+  return true;
+}
+
+void CYdLidar::leaveStandby() {
+  if (m_lowPower) {
+    function_state state;
+    lidarPtr->disableLowPower(state);
+    m_lowPower = false;
+  }
+}
+
+bool CYdLidar::isStandby() const {
+  return m_standby;
+}
+
+/*-------------------------------------------------------------
+						reconfigure
+-------------------------------------------------------------*/
+LidarSettings CYdLidar::getSettings() const {
+  ScopedLocker l(m_filterLock);
+  LidarSettings settings;
+  settings.scan_frequency = m_ScanFrequency;
+  settings.sample_rate = m_SampleRate;
+  settings.min_range = m_MinRange;
+  settings.max_range = m_MaxRange;
+  settings.min_angle = m_MinAngle;
+  settings.max_angle = m_MaxAngle;
+  settings.ignore = m_IgnoreArray;
+  return settings;
+}
+
+bool CYdLidar::reconfigure(const LidarSettings &settings) {
+  {
+    ScopedLocker l(m_filterLock);
+    m_MinRange = settings.min_range;
+    m_MaxRange = settings.max_range;
+    m_MinAngle = settings.min_angle;
+    m_MaxAngle = settings.max_angle;
+    m_IgnoreArray = settings.ignore;
+  }
+  updateFilter(true);
+
+  bool frequency = hasScanFrequencyCtrl(lidar_model) &&
+                   fabs(settings.scan_frequency - m_ScanFrequency) >= 0.05f;
+  bool sampleRate = hasSampleRate(lidar_model) &&
+                    settings.sample_rate != m_SampleRate;
+
+  if (!frequency && !sampleRate) {
+    return true;
+  }
+
+  if (!lidarPtr || !lidarPtr->isconnected() || m_SingleChannel) {
+    fprintf(stderr, "[CYdLidar] Scan frequency and sample rate can not be changed now\n");
+    fflush(stderr);
+    return false;
+  }
+
+  bool scanning = isScanning && lidarPtr->isscanning();
+  bool ret = true;
+
+  {
+    PortExchange exchange(m_ioLock, lidarPtr, m_ExternalLoop);
+    m_reconfiguring = true;
+
+    if (scanning) {
+      lidarPtr->pauseScan();
+    }
+
+    if (sampleRate) {
+      m_SampleRate = settings.sample_rate;
+      m_UserSampleRate = m_SampleRate;
+      checkSampleRate();
+    }
+
+    m_ScanFrequency = settings.scan_frequency;
+
+    //the revolution size depends on both.
+    if (hasScanFrequencyCtrl(lidar_model)) {
+      checkScanFrequency();
+    } else {
+      m_FixedSize = m_SampleRate * 1000 / (m_ScanFrequency - 0.1);
+    }
+
+    m_PointTime = 1e9 / (m_SampleRate * 1000);
+    lidarPtr->setPointTime(m_PointTime);
+    //every scan from now on comes with the new settings.
+    updateFilter(true);
+    ret = !scanning || IS_OK(lidarPtr->continueScan());
+    //a new revolution size to learn, not a reason to distrust the device.
+    m_reconnectCount = lidarPtr->getReconnectCount();
+    m_revalidateScans = 0;
+    m_scanPoints = 0.f;
+    m_reconfiguring = false;
+  }
+
+  if (!ret) {
+    fprintf(stderr, "[CYdLidar] Failed to continue scanning after reconfiguring\n");
+    fflush(stderr);
+    turnOff();
+    return false;
+  }
+
+  printf("[YDLIDAR INFO] Reconfigured to %dK at %fHz\n", m_SampleRate,
+         m_ScanFrequency);
+  fflush(stdout);
+  return true;
+}
+
+bool CYdLidar::getMotorState(bool &running) {
+  if (!lidarPtr || isScanning) {
+    return false;
+  }
+
+  function_state state;
+
+  if (!IS_OK(lidarPtr->getMotorState(state))) {
+    return false;
+  }
+
+  running = state.state != 0;
+  return true;
+}
+
 /*-------------------------------------------------------------
             checkLidarAbnormal
 -------------------------------------------------------------*/
@@ -627,7 +1482,6 @@ bool CYdLidar::getDeviceInfo() {
     m_lidarHardVer = std::to_string(devinfo.hardware_version & 0xff);
   }
 
-  m_UserSampleRate = m_SampleRate;
 
   if (hasSampleRate(devinfo.model)) {
     checkSampleRate();
@@ -691,6 +1545,293 @@ void CYdLidar::printfVersionInfo(const device_info &info) {
   printf("\n");
 }
 
+bool CYdLidar::loadProfile() {
+  std::string key = m_SerialPort;
+
+  //single channel devices answer nothing before scanning, their serial number
+  //is checked in-stream.
+  if (!m_SingleChannel) {
+    device_info devinfo;
+    result_t op_result = lidarPtr->getDeviceInfo(devinfo);
+
+    if (!IS_OK(op_result) || (devinfo.firmware_version == 0 &&
+                              devinfo.hardware_version == 0)) {
+      return false;
+    }
+
+    key.clear();
+
+    for (int i = 0; i < 16; i++) {
+      key += std::to_string(devinfo.serialnum[i] & 0xff);
+    }
+  }
+
+  LidarProfile profile;
+  std::string file = LidarProfile::fileName(m_ProfileCacheDir, key);
+
+  if (!profile.load(file) ||
+      !profile.matches(m_UserSampleRate, m_UserScanFrequency, m_SingleChannel) ||
+      (!m_SingleChannel && profile.serial != key) ||
+      !isSupportLidar(profile.model)) {
+    return false;
+  }
+
+  m_profileFile = file;
+  lidar_model = profile.model;
+  m_LidarType = profile.lidar_type;
+  lidarPtr->setLidarType(m_LidarType);
+  lidarPtr->setIntensities(profile.intensities);
+  Major = static_cast<uint8_t>(profile.major);
+  Minjor = static_cast<uint8_t>(profile.minor);
+  m_lidarSerialNum = profile.serial;
+  m_lidarSoftVer = std::to_string(Major & 0xff) + "." + std::to_string(
+                     Minjor & 0xff);
+  m_lidarHardVer = std::to_string(profile.hardware & 0xff);
+  defalutSampleRate = profile.default_sample_rate;
+  m_SampleRate = profile.sample_rate;
+  m_ScanFrequency = profile.scan_frequency;
+  m_FixedSize = profile.fixed_size;
+  m_PointTime = profile.point_time;
+  lidarPtr->setPointTime(m_PointTime);
+  m_AngleOffset = profile.angle_offset;
+  m_isAngleOffsetCorrected = profile.angle_offset_corrected;
+  m_ParseSuccess = true;
+  printf("[YDLIDAR INFO] Fast start of LiDAR[%s] %s on [%s], using the cached profile\n",
+         m_lidarSerialNum.c_str(), lidarModelToString(lidar_model).c_str(),
+         m_SerialPort.c_str());
+  fflush(stdout);
+  return true;
+}
+
+void CYdLidar::saveProfile() {
+  if (m_ProfileCacheDir.empty() || m_lidarSerialNum.empty()) {
+    return;
+  }
+
+  LidarProfile profile;
+  profile.serial = m_lidarSerialNum;
+  profile.model = lidar_model;
+  profile.lidar_type = m_LidarType;
+  profile.single_channel = m_SingleChannel;
+  profile.intensities = hasIntensity(lidar_model);
+  profile.major = Major;
+  profile.minor = Minjor;
+  profile.hardware = atoi(m_lidarHardVer.c_str());
+  profile.requested_sample_rate = m_UserSampleRate;
+  profile.requested_frequency = m_UserScanFrequency;
+  profile.sample_rate = m_SampleRate;
+  profile.default_sample_rate = defalutSampleRate;
+  profile.scan_frequency = m_ScanFrequency;
+  profile.fixed_size = m_FixedSize;
+  profile.point_time = m_PointTime;
+  profile.angle_offset = m_AngleOffset;
+  profile.angle_offset_corrected = m_isAngleOffsetCorrected;
+  std::string file = LidarProfile::fileName(m_ProfileCacheDir,
+                     m_SingleChannel ? m_SerialPort : m_lidarSerialNum);
+
+  if (!profile.save(file)) {
+    fprintf(stderr, "[CYdLidar] Failed to save the LiDAR profile to %s\n",
+            file.c_str());
+    fflush(stderr);
+  }
+}
+
+void CYdLidar::dropProfile() {
+  fprintf(stderr, "[CYdLidar] The cached profile %s is stale, deleting it\n",
+          m_profileFile.c_str());
+  fflush(stderr);
+  remove(m_profileFile.c_str());
+  m_profileLoaded = false;
+  m_profileTrusted = false;
+}
+
+std::string CYdLidar::probeSerialNumber(const std::string &port,
+                                        int baudrate, bool single_channel,
+                                        const std::atomic<bool> &cancel) {
+  const uint32_t kProbeTimeout = 300;
+  //single channel LiDARs need their motor started and a few revolutions.
+  const uint32_t kStreamTimeout = 3000;
+  YDlidarDriver driver;
+  driver.setSingleChannel(single_channel);
+  driver.setAutoReconnect(false);
+
+  if (!IS_OK(driver.connect(port.c_str(), baudrate))) {
+    return "";
+  }
+
+  std::string serial_number;
+  device_info info;
+
+  if (!single_channel) {
+    if (IS_OK(driver.getDeviceInfo(info, kProbeTimeout)) &&
+        (info.firmware_version != 0 || info.hardware_version != 0)) {
+      for (int i = 0; i < 16; i++) {
+        serial_number += std::to_string(info.serialnum[i] & 0xff);
+      }
+    }
+  } else if (IS_OK(driver.startScan())) {
+    std::vector<node_info> nodes(YDlidarDriver::MAX_SCAN_NODES);
+    uint32_t start = getms();
+
+    while (serial_number.empty() && !cancel &&
+           getms() - start < kStreamTimeout) {
+      size_t count = nodes.size();
+
+      if (IS_OK(driver.grabScanData(&nodes[0], count, kProbeTimeout))) {
+        parseStreamDeviceInfo(&nodes[0], static_cast<int>(count), info,
+                              serial_number);
+      }
+    }
+
+    driver.stop();
+  }
+
+  driver.disconnect();
+  return serial_number;
+}
+
+bool CYdLidar::resolvePort() {
+  //ports another instance probes may be free once its probe finished.
+  const uint32_t kResolveTimeout = 5000;
+  const uint32_t kRetryInterval = 50;
+  std::vector<PortInfo> ports = YDlidarDriver::lidarPortInfoList();
+  std::vector<bool> pending(ports.size(), true);
+  std::atomic<bool> cancel(false);
+  LidarIdentity identity;
+  int found = -1;
+
+  if (!m_ProfileCacheDir.empty() &&
+      identity.load(LidarIdentity::fileName(m_ProfileCacheDir,
+                    m_DeviceSerialNumber)) &&
+      identity.serial == m_DeviceSerialNumber) {
+    int index = identity.locate(ports);
+
+    if (index >= 0) {
+      std::string port = canonicalPort(ports[index].port);
+      pending[index] = false;
+
+      //checkIdentity catches a swapped single channel LiDAR once scanning.
+      if (claimPort(port, PORT_PROBING) == PORT_FREE &&
+          (m_SingleChannel ||
+           probeSerialNumber(ports[index].port, m_SerialBaudrate, false,
+                             cancel) == m_DeviceSerialNumber)) {
+        found = index;
+      } else {
+        releasePort(port);
+      }
+    }
+  }
+
+  uint32_t start = getms();
+
+  while (found < 0 && getms() - start < kResolveTimeout) {
+    std::vector<size_t> probed;
+    std::vector<std::future<std::string> > probes;
+    bool busy = false;
+
+    for (size_t i = 0; i < ports.size(); i++) {
+      if (!pending[i]) {
+        continue;
+      }
+
+      PortState state = claimPort(canonicalPort(ports[i].port), PORT_PROBING);
+
+      if (state != PORT_FREE) {
+        //a connected port belongs to another LiDAR for good.
+        pending[i] = state == PORT_PROBING;
+        busy = busy || pending[i];
+        continue;
+      }
+
+      pending[i] = false;
+      probed.push_back(i);
+      probes.push_back(std::async(std::launch::async, probeSerialNumber,
+                                  ports[i].port, m_SerialBaudrate,
+                                  m_SingleChannel, std::cref(cancel)));
+    }
+
+    for (size_t i = 0; i < probes.size(); i++) {
+      if (probes[i].get() == m_DeviceSerialNumber && found < 0) {
+        found = static_cast<int>(probed[i]);
+        cancel = true;
+      } else {
+        releasePort(canonicalPort(ports[probed[i]].port));
+      }
+    }
+
+    if (!busy) {
+      break;
+    }
+
+    if (found < 0) {
+      delay(kRetryInterval);
+    }
+  }
+
+  if (found < 0) {
+    return false;
+  }
+
+  //checkCOMMs takes the claim over.
+  disconnecting();
+  m_SerialPort = ports[found].port;
+  m_claimedPort = canonicalPort(m_SerialPort);
+  printf("[YDLIDAR INFO] LiDAR[%s] found on [%s]\n",
+         m_DeviceSerialNumber.c_str(), m_SerialPort.c_str());
+  fflush(stdout);
+  return true;
+}
+
+void CYdLidar::saveIdentity() {
+  if (m_ProfileCacheDir.empty() || m_lidarSerialNum.empty()) {
+    return;
+  }
+
+  std::string port = canonicalPort(m_SerialPort);
+  std::vector<PortInfo> ports = YDlidarDriver::lidarPortInfoList();
+
+  for (size_t i = 0; i < ports.size(); i++) {
+    if (canonicalPort(ports[i].port) != port) {
+      continue;
+    }
+
+    LidarIdentity identity;
+    identity.serial = m_lidarSerialNum;
+    identity.usb_path = ports[i].usb_path;
+    identity.usb_serial = ports[i].serial_number;
+    identity.port = ports[i].port;
+    std::string file = LidarIdentity::fileName(m_ProfileCacheDir,
+                       m_lidarSerialNum);
+    LidarIdentity saved;
+
+    if ((saved.load(file) && saved == identity) || identity.save(file)) {
+      return;
+    }
+
+    fprintf(stderr, "[CYdLidar] Failed to save the LiDAR identity to %s\n",
+            file.c_str());
+    fflush(stderr);
+    return;
+  }
+}
+
+bool CYdLidar::checkIdentity() const {
+  return m_DeviceSerialNumber.empty() || m_lidarSerialNum.empty() ||
+         m_lidarSerialNum == m_DeviceSerialNumber;
+}
+
+void CYdLidar::dropIdentity() {
+  fprintf(stderr, "[CYdLidar] LiDAR[%s] on [%s] is not LiDAR[%s]\n",
+          m_lidarSerialNum.c_str(), m_SerialPort.c_str(),
+          m_DeviceSerialNumber.c_str());
+  fflush(stderr);
+
+  if (!m_ProfileCacheDir.empty()) {
+    remove(LidarIdentity::fileName(m_ProfileCacheDir,
+                                   m_DeviceSerialNumber).c_str());
+  }
+}
+
 void CYdLidar::checkSampleRate() {
   sampling_rate _rate;
   _rate.rate = 3;
@@ -786,6 +1927,7 @@ bool CYdLidar::checkScanFrequency() {
   scan_frequency _scan_frequency;
   float hz = 0;
   result_t ans = RESULT_FAIL;
+  bool confirmed = false;
 
   if (isSupportScanFrequency(lidar_model, m_ScanFrequency)) {
     m_ScanFrequency += frequencyOffset;
@@ -794,32 +1936,42 @@ bool CYdLidar::checkScanFrequency() {
     if (IS_OK(ans)) {
       frequency = _scan_frequency.frequency / 100.f;
       hz = m_ScanFrequency - frequency;
+      std::vector<uint8_t> cmds;
 
       if (hz > 0) {
         while (hz > 0.95) {
-          lidarPtr->setScanFrequencyAdd(_scan_frequency);
+          cmds.push_back(LIDAR_CMD_SET_AIMSPEED_ADD);
           hz = hz - 1.0;
         }
 
         while (hz > 0.09) {
-          lidarPtr->setScanFrequencyAddMic(_scan_frequency);
+          cmds.push_back(LIDAR_CMD_SET_AIMSPEED_ADDMIC);
           hz = hz - 0.1;
         }
-
-        frequency = _scan_frequency.frequency / 100.0f;
       } else {
         while (hz < -0.95) {
-          lidarPtr->setScanFrequencyDis(_scan_frequency);
+          cmds.push_back(LIDAR_CMD_SET_AIMSPEED_DIS);
           hz = hz + 1.0;
         }
 
         while (hz < -0.09) {
-          lidarPtr->setScanFrequencyDisMic(_scan_frequency);
+          cmds.push_back(LIDAR_CMD_SET_AIMSPEED_DISMIC);
           hz = hz + 0.1;
         }
+      }
 
-        frequency = _scan_frequency.frequency / 100.0f;
+      //all steps in one write, every reply carries the resulting frequency.
+      std::vector<uint8_t> replies;
+      ans = lidarPtr->sendCommandBatch(cmds, sizeof(_scan_frequency), replies);
+
+      if (replies.size() >= sizeof(_scan_frequency)) {
+        memcpy(&_scan_frequency,
+               &replies[replies.size() - sizeof(_scan_frequency)],
+               sizeof(_scan_frequency));
       }
+
+      confirmed = IS_OK(ans);
+      frequency = _scan_frequency.frequency / 100.0f;
     }
   } else {
     m_ScanFrequency += frequencyOffset;
@@ -827,7 +1979,9 @@ bool CYdLidar::checkScanFrequency() {
             m_ScanFrequency - frequencyOffset);
   }
 
-  ans = lidarPtr->getScanFrequency(_scan_frequency);
+  if (!confirmed) {
+    ans = lidarPtr->getScanFrequency(_scan_frequency);
+  }
 
   if (IS_OK(ans)) {
     frequency = _scan_frequency.frequency / 100.0f;
@@ -925,8 +2079,14 @@ bool  CYdLidar::checkCOMMs() {
   }
 
   printf("LiDAR successfully connected\n");
+  m_claimedPort = canonicalPort(m_SerialPort);
+  claimPort(m_claimedPort, PORT_CONNECTED);
   lidarPtr->setSingleChannel(m_SingleChannel);
   lidarPtr->setLidarType(m_LidarType);
+  lidarPtr->setThreadless(m_Threadless);
+  lidarPtr->setExternalLoop(m_ExternalLoop);
+  lidarPtr->setThreadOptions(m_ThreadOptions);
+  lidarPtr->setStallCallback(m_stallCallback);
 
   return true;
 }
@@ -940,6 +2100,7 @@ bool CYdLidar::checkStatus() {
     return false;
   }
 
+  reportProgress(BRINGUP_CHECKING_HEALTH);
   bool ret = getDeviceHealth();
 
   if (!ret) {
@@ -951,6 +2112,8 @@ bool CYdLidar::checkStatus() {
     }
   }
 
+  reportProgress(BRINGUP_READING_INFO);
+
   if (!getDeviceInfo()) {
     delay(2000);
     ret = getDeviceInfo();
@@ -978,25 +2141,105 @@ bool CYdLidar::checkHardware() {
   return false;
 }
 
+/*-------------------------------------------------------------
+						autoDetect
+-------------------------------------------------------------*/
+bool CYdLidar::autoDetect(uint32_t timeout) {
+  if (lidarPtr && lidarPtr->isconnected()) {
+    fprintf(stderr, "[CYdLidar::autoDetect] port[%s] is already connected\n",
+            m_SerialPort.c_str());
+    return false;
+  }
+
+  LidarDetectInfo info;
+  result_t ans = YDlidarDriver::detectLidar(m_SerialPort, info, timeout);
+
+  if (!IS_OK(ans)) {
+    fprintf(stderr, "[CYdLidar::autoDetect] No LiDAR found in port[%s]\n",
+            m_SerialPort.c_str());
+    return false;
+  }
+
+  m_SerialBaudrate = info.baudrate;
+  m_SingleChannel = info.single_channel;
+
+  if (!info.single_channel) {
+    m_LidarType = info.lidar_type;
+  }
+
+  printf("[YDLIDAR INFO] Detected %s LiDAR[%s] in port[%s] and baudrate[%d]\n",
+         info.single_channel ? "single channel" : "dual channel",
+         info.model < 0 ? "unknown" : lidarModelToString(info.model).c_str(),
+         m_SerialPort.c_str(), m_SerialBaudrate);
+  fflush(stdout);
+  return true;
+}
+
 /*-------------------------------------------------------------
 						initialize
 -------------------------------------------------------------*/
 bool CYdLidar::initialize() {
+  reportProgress(BRINGUP_CONNECTING);
+
+  if (!m_DeviceSerialNumber.empty()) {
+    //let go of a wrong LiDAR found by an earlier call.
+    if (!checkIdentity()) {
+      disconnecting();
+      m_lidarSerialNum.clear();
+    }
+
+    if ((!lidarPtr || !lidarPtr->isconnected()) && !resolvePort()) {
+      fprintf(stderr, "[CYdLidar::initialize] LiDAR[%s] was not found\n",
+              m_DeviceSerialNumber.c_str());
+      fflush(stderr);
+      reportProgress(BRINGUP_FAILED);
+      return false;
+    }
+  }
+
   if (!checkCOMMs()) {
     fprintf(stderr,
             "[CYdLidar::initialize] Error initializing YDLIDAR check Comms.\n");
     fflush(stderr);
+
+    //do not keep a port found by serial number from other instances.
+    if (!m_claimedPort.empty() && !lidarPtr->isconnected()) {
+      releasePort(m_claimedPort);
+      m_claimedPort.clear();
+    }
+
+    reportProgress(BRINGUP_FAILED);
     return false;
   }
 
-  if (!checkStatus()) {
+  m_UserSampleRate = m_SampleRate;
+  m_UserScanFrequency = m_ScanFrequency;
+
+  if (m_FastStart && !m_ProfileCacheDir.empty()) {
+    reportProgress(BRINGUP_READING_INFO);
+    m_profileLoaded = loadProfile();
+  } else {
+    m_profileLoaded = false;
+  }
+
+  if (!m_profileLoaded && !checkStatus()) {
     fprintf(stderr,
             "[CYdLidar::initialize] Error initializing YDLIDAR check status in port[%s] and baudrate[%d]\n", m_SerialPort.c_str(), m_SerialBaudrate);
     fflush(stderr);
+    reportProgress(BRINGUP_FAILED);
+    return false;
+  }
+
+  if (!checkIdentity()) {
+    dropIdentity();
+    disconnecting();
+    m_lidarSerialNum.clear();
+    reportProgress(BRINGUP_FAILED);
     return false;
   }
 
   printf("LiDAR init success!\n");
   fflush(stdout);
+  reportProgress(BRINGUP_INITIALIZED);
   return true;
 }
@@ -0,0 +1,800 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#include "channel_device.h"
+#include "locker.h"
+#include "serial.h"
+#include "timer.h"
+#include "ydlidar_protocol.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/timerfd.h>
+#endif
+
+namespace ydlidar {
+
+namespace {
+
+/*!
+ * @brief serial port, the default channel
+ */
+class SerialChannel : public ChannelDevice {
+ public:
+  SerialChannel(const std::string &port, uint32_t baudrate, uint32_t timeout)
+    : m_serial(port, baudrate, serial::Timeout::simpleTimeout(timeout)) {
+  }
+
+  virtual bool open() {
+    return m_serial.open();
+  }
+
+  virtual bool isOpen() {
+    return m_serial.isOpen();
+  }
+
+  virtual void closePort() {
+    m_serial.closePort();
+  }
+
+  virtual void flush() {
+    m_serial.flush();
+  }
+
+  virtual size_t available() {
+    return m_serial.available();
+  }
+
+  virtual int waitfordata(size_t data_count, uint32_t timeout,
+                          size_t *returned_size) {
+    return m_serial.waitfordata(data_count, timeout, returned_size);
+  }
+
+  virtual size_t writeData(const uint8_t *data, size_t size) {
+    return m_serial.write(data, size);
+  }
+
+  virtual size_t readData(uint8_t *data, size_t size) {
+    return m_serial.read(data, size);
+  }
+
+  virtual bool setDTR(bool level) {
+    return m_serial.setDTR(level);
+  }
+
+  virtual uint32_t getByteTime() {
+    return m_serial.getByteTime();
+  }
+
+  virtual int getFileDescriptor() {
+    return m_serial.getFileDescriptor();
+  }
+
+  virtual void setWakeupDescriptor(int fd) {
+    m_serial.setWakeupDescriptor(fd);
+  }
+
+ private:
+  serial::Serial m_serial;
+};
+
+#if !defined(_WIN32)
+
+/*!
+ * @brief channel over a POSIX descriptor
+ * @note Reads are buffered, so datagrams are never truncated and ::available
+ * works on any descriptor.
+ */
+class DescriptorChannel : public ChannelDevice {
+ public:
+  enum Kind {
+    KIND_STREAM,      ///< socket or pipe, end of stream is an error
+    KIND_DATAGRAM,    ///< UDP socket
+    KIND_FILE,        ///< recorded stream, paced by the baudrate if known
+  };
+
+  DescriptorChannel(Kind kind, uint32_t baudrate, uint32_t timeout)
+    : m_kind(kind), m_fd(-1), m_wakeupFd(-1), m_timeout(timeout),
+      m_byteTime(baudrate > 0 ? 10 * 1000000000ULL / baudrate : 0),
+      m_offset(0), m_eof(false), m_loop(false), m_playing(kind != KIND_FILE),
+      m_playStart(0), m_played(0), m_timerFd(-1), m_timerArmed(false),
+      m_readySet(false), m_writable(true), m_connected(false), m_peerLen(0) {
+    memset(&m_peer, 0, sizeof(m_peer));
+  }
+
+  virtual ~DescriptorChannel() {
+    closeDescriptor();
+  }
+
+  virtual bool isOpen() {
+    return m_fd >= 0;
+  }
+
+  virtual void closePort() {
+    closeDescriptor();
+  }
+
+  virtual size_t available() {
+    pull();
+    return m_buffer.size() - m_offset;
+  }
+
+  virtual int waitfordata(size_t data_count, uint32_t timeout,
+                          size_t *returned_size) {
+    size_t length = 0;
+
+    if (returned_size == NULL) {
+      returned_size = &length;
+    }
+
+    uint32_t start = getms();
+
+    while (m_fd >= 0) {
+      bool alive = pull(data_count);
+      *returned_size = m_buffer.size() - m_offset;
+
+      if (*returned_size >= data_count) {
+        return 0;
+      }
+
+      if (!alive) {
+        return -2;
+      }
+
+      uint32_t elapsed = getms() - start;
+
+      if (elapsed >= timeout) {
+        return -1;
+      }
+
+      //a file is always readable, so a replay sleeps until the line would
+      //have carried the missing bytes; one that ended or is stopped stays
+      //silent and only a wake up ends the wait.
+      int wait = timeout - elapsed;
+      pollfd fds[2];
+      nfds_t count = 0;
+
+      if (m_kind == KIND_FILE) {
+        if (!m_eof && m_playing) {
+          uint64_t missing = (data_count - *returned_size) * m_byteTime / 1000000;
+          wait = std::min<uint64_t>(wait, std::max<uint64_t>(missing, 1));
+        }
+      } else {
+        fds[count].fd = m_fd;
+        fds[count].events = POLLIN;
+        count++;
+      }
+
+      if (m_wakeupFd >= 0) {
+        fds[count].fd = m_wakeupFd;
+        fds[count].events = POLLIN;
+        count++;
+      }
+
+      int n = poll(fds, count, wait);
+
+      if (n < 0 && errno != EINTR) {
+        return -2;
+      }
+
+      if (n > 0 && m_wakeupFd >= 0 && fds[count - 1].revents) {
+        return -1;
+      }
+    }
+
+    return -2;
+  }
+
+  virtual size_t writeData(const uint8_t *data, size_t size) {
+    if (m_fd < 0) {
+      return 0;
+    }
+
+    if (!m_writable) {
+      if (m_kind == KIND_FILE) {
+        replayCommand(data, size);
+      }
+
+      return size;
+    }
+
+    if (m_kind == KIND_DATAGRAM) {
+      //a bound socket answers whoever sent last.
+      ssize_t r = m_peerLen > 0 ?
+                  sendto(m_fd, data, size, 0,
+                         reinterpret_cast<const sockaddr *>(&m_peer), m_peerLen) :
+                  send(m_fd, data, size, 0);
+      return r > 0 ? static_cast<size_t>(r) : 0;
+    }
+
+    uint32_t start = getms();
+
+    while (getms() - start < m_timeout) {
+      ssize_t r = ::write(m_fd, data, size);
+
+      if (r > 0) {
+        return static_cast<size_t>(r);
+      }
+
+      if (r < 0 && errno != EAGAIN && errno != EINTR) {
+        return 0;
+      }
+
+      pollfd fds;
+      fds.fd = m_fd;
+      fds.events = POLLOUT;
+      poll(&fds, 1, m_timeout - (getms() - start));
+    }
+
+    return 0;
+  }
+
+  virtual size_t readData(uint8_t *data, size_t size) {
+    size_t length = m_buffer.size() - m_offset;
+
+    if (length == 0 && waitfordata(1, m_timeout, &length) != 0) {
+      return 0;
+    }
+
+    length = std::min(length, size);
+    memcpy(data, &m_buffer[m_offset], length);
+    m_offset += length;
+
+    if (m_offset == m_buffer.size()) {
+      m_buffer.clear();
+      m_offset = 0;
+    }
+
+    if (m_kind == KIND_FILE) {
+      updateReady();
+    }
+
+    return length;
+  }
+
+  virtual uint32_t getByteTime() {
+    return static_cast<uint32_t>(m_byteTime);
+  }
+
+  virtual int getFileDescriptor() {
+    if (m_kind != KIND_FILE || m_fd < 0) {
+      return m_fd;
+    }
+
+    //a regular file always polls readable, even with nothing due, so a
+    //level-triggered loop would spin on it.
+    return m_timerFd >= 0 ? m_timerFd : m_ready.fd();
+  }
+
+  virtual void setWakeupDescriptor(int fd) {
+    m_wakeupFd = fd;
+  }
+
+ protected:
+  //! take over an opened descriptor
+  bool attach(int fd) {
+    if (fd < 0) {
+      return false;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    m_fd = fd;
+    m_buffer.clear();
+    m_offset = 0;
+    m_eof = false;
+    m_peerLen = 0;
+#if defined(__linux__)
+
+    if (m_kind == KIND_FILE && m_byteTime > 0) {
+      m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    }
+
+#endif
+    return true;
+  }
+
+  void closeDescriptor() {
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+
+    if (m_timerFd >= 0) {
+      ::close(m_timerFd);
+      m_timerFd = -1;
+      m_timerArmed = false;
+    }
+
+    m_ready.clear();
+    m_readySet = false;
+    m_buffer.clear();
+    m_offset = 0;
+  }
+
+  /*!
+   * @brief read what is pending into the buffer, without blocking
+   * @param[in] want  bytes the reader waits for
+   * @return false once the stream ended or failed
+   */
+  bool pull(size_t want = 0) {
+    bool alive = pullData(want);
+
+    if (m_kind == KIND_FILE) {
+      updateReady();
+    }
+
+    return alive;
+  }
+
+  bool pullData(size_t want) {
+    //bounds the memory a fast file or socket can take between two reads.
+    const size_t kMaxBuffered = 65536;
+    uint8_t chunk[4096];
+
+    if (m_offset > 0 && m_offset == m_buffer.size()) {
+      m_buffer.clear();
+      m_offset = 0;
+    }
+
+    while (m_fd >= 0 && !m_eof && m_playing &&
+           m_buffer.size() - m_offset < kMaxBuffered) {
+      ssize_t r;
+
+      if (m_kind == KIND_FILE) {
+        //no faster than the LiDAR sent it.
+        size_t length = sizeof(chunk);
+
+        if (m_byteTime > 0) {
+          uint64_t due = (getTime() - m_playStart) / m_byteTime;
+          length = std::min<uint64_t>(length, due - std::min(due, m_played));
+        } else {
+          //unpaced, stay just ahead of the reader, so a flush drops about
+          //as much as on a serial port.
+          size_t ahead = std::max<size_t>(want, 256);
+          size_t buffered = m_buffer.size() - m_offset;
+          length = std::min(length, ahead - std::min(ahead, buffered));
+        }
+
+        if (length == 0) {
+          return true;
+        }
+
+        r = ::read(m_fd, chunk, length);
+        m_played += r > 0 ? r : 0;
+      } else if (m_kind == KIND_DATAGRAM) {
+        sockaddr_storage peer;
+        socklen_t peer_len = sizeof(peer);
+        r = recvfrom(m_fd, chunk, sizeof(chunk), 0,
+                     reinterpret_cast<sockaddr *>(&peer), &peer_len);
+
+        if (r >= 0 && !m_connected) {
+          m_peer = peer;
+          m_peerLen = peer_len;
+        }
+      } else {
+        r = ::read(m_fd, chunk, sizeof(chunk));
+      }
+
+      if (r > 0) {
+        m_buffer.insert(m_buffer.end(), chunk, chunk + r);
+        continue;
+      }
+
+      if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return true;
+      }
+
+      if (r == 0 && m_kind == KIND_DATAGRAM) {
+        continue;
+      }
+
+      if (r == 0 && m_kind == KIND_FILE) {
+        if (m_loop && lseek(m_fd, 0, SEEK_SET) == 0) {
+          continue;
+        }
+
+        m_eof = true;
+        return true;
+      }
+
+      return false;
+    }
+
+    return m_fd >= 0;
+  }
+
+  /*!
+   * @brief a recording is what the LiDAR sent after a scan command, so a scan
+   * command plays it from the start and a stop command pauses it
+   */
+  void replayCommand(const uint8_t *data, size_t size) {
+    for (size_t i = 0; i + 1 < size; i++) {
+      if (data[i] != LIDAR_CMD_SYNC_BYTE) {
+        continue;
+      }
+
+      uint8_t cmd = data[i + 1];
+
+      if (cmd == LIDAR_CMD_SCAN || cmd == LIDAR_CMD_FORCE_SCAN) {
+        m_playing = lseek(m_fd, 0, SEEK_SET) == 0;
+        m_playStart = getTime();
+        m_played = 0;
+      } else if (cmd == LIDAR_CMD_STOP || cmd == LIDAR_CMD_FORCE_STOP) {
+        m_playing = false;
+      } else {
+        continue;
+      }
+
+      m_buffer.clear();
+      m_offset = 0;
+      m_eof = false;
+    }
+
+    updateReady();
+  }
+
+  /*!
+   * @brief keep the descriptor of ::getFileDescriptor readable only while a
+   * replay has data for its reader
+   * @note A paced replay ticks a timer about every package, the unpaced one
+   * stays signalled until the file ran out.
+   */
+  void updateReady() {
+    bool due = m_playing && !m_eof;
+#if defined(__linux__)
+
+    if (m_timerFd >= 0) {
+      uint64_t expirations = 0;
+      ssize_t ret = ::read(m_timerFd, &expirations, sizeof(expirations));
+      (void)ret;
+
+      if (due != m_timerArmed) {
+        itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+
+        if (due) {
+          uint64_t period = std::max<uint64_t>(64 * m_byteTime, 1000000);
+          spec.it_interval.tv_sec = period / 1000000000;
+          spec.it_interval.tv_nsec = period % 1000000000;
+          spec.it_value = spec.it_interval;
+        }
+
+        timerfd_settime(m_timerFd, 0, &spec, NULL);
+        m_timerArmed = due;
+      }
+
+      return;
+    }
+
+#endif
+    bool ready = due || m_offset < m_buffer.size();
+
+    if (ready != m_readySet) {
+      if (ready) {
+        m_ready.set();
+      } else {
+        m_ready.clear();
+      }
+
+      m_readySet = ready;
+    }
+  }
+
+  Kind m_kind;
+  int m_fd;                         ///< 描述符
+  int m_wakeupFd;                   ///< 唤醒描述符
+  uint32_t m_timeout;               ///< 读写超时(ms)
+  uint64_t m_byteTime;              ///< 雷达串口传输一个byte时间(ns)
+  std::vector<uint8_t> m_buffer;    ///< 已读取未取走的数据
+  size_t m_offset;                  ///< 已取走的长度
+  bool m_eof;                       ///< 回放文件已结束
+  bool m_loop;                      ///< 回放文件循环播放
+  bool m_playing;                   ///< 回放文件正在播放
+  uint64_t m_playStart;             ///< 开始回放时间(ns)
+  uint64_t m_played;                ///< 已回放的字节数
+  int m_timerFd;                    ///< 按波特率回放的节拍定时器
+  bool m_timerArmed;                ///< 节拍定时器已启动
+  PollEvent m_ready;                ///< 不按波特率回放时, 有数据可读
+  bool m_readySet;                  ///< m_ready已置位
+  bool m_writable;                  ///< 写入是否送达, 否则丢弃
+  bool m_connected;                 ///< 数据报套接字已连接对端
+  sockaddr_storage m_peer;          ///< 绑定端口时最后的发送方
+  socklen_t m_peerLen;
+};
+
+/*!
+ * @brief split "host:port" or "[v6]:port"
+ */
+bool splitHostPort(const std::string &address, std::string &host,
+                   std::string &port) {
+  size_t pos = address.rfind(':');
+
+  if (pos == std::string::npos || pos + 1 >= address.size()) {
+    return false;
+  }
+
+  host = address.substr(0, pos);
+  port = address.substr(pos + 1);
+
+  if (host.size() >= 2 && host[0] == '[' && host[host.size() - 1] == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+
+  return true;
+}
+
+/*!
+ * @brief TCP client or UDP socket
+ */
+class SocketChannel : public DescriptorChannel {
+ public:
+  SocketChannel(bool datagram, const std::string &address, uint32_t baudrate,
+                uint32_t timeout)
+    : DescriptorChannel(datagram ? KIND_DATAGRAM : KIND_STREAM, baudrate,
+                        timeout),
+      m_address(address) {
+  }
+
+  virtual bool open() {
+    if (isOpen()) {
+      return true;
+    }
+
+    std::string host, port;
+
+    if (!splitHostPort(m_address, host, port)) {
+      fprintf(stderr, "Invalid socket address: %s\n", m_address.c_str());
+      return false;
+    }
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = m_kind == KIND_DATAGRAM ? SOCK_DGRAM : SOCK_STREAM;
+    //udp://:port listens instead of connecting.
+    bool bind_only = m_kind == KIND_DATAGRAM && host.empty();
+
+    if (bind_only) {
+      hints.ai_flags = AI_PASSIVE;
+    }
+
+    addrinfo *result = NULL;
+
+    if (getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints,
+                    &result) != 0) {
+      fprintf(stderr, "Failed to resolve %s\n", m_address.c_str());
+      return false;
+    }
+
+    for (addrinfo *ai = result; ai && !isOpen(); ai = ai->ai_next) {
+      int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+      if (fd < 0) {
+        continue;
+      }
+
+      attach(fd);
+      bool ok = bind_only ? ::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 :
+                connectWithTimeout(ai);
+
+      if (!ok) {
+        closeDescriptor();
+      }
+    }
+
+    freeaddrinfo(result);
+    m_connected = isOpen() && !bind_only;
+
+    if (isOpen() && m_kind == KIND_STREAM) {
+      int flag = 1;
+      setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+
+    return isOpen();
+  }
+
+ private:
+  bool connectWithTimeout(const addrinfo *ai) {
+    if (connect(m_fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      return true;
+    }
+
+    if (errno != EINPROGRESS) {
+      return false;
+    }
+
+    pollfd fds;
+    fds.fd = m_fd;
+    fds.events = POLLOUT;
+    int error = 0;
+    socklen_t len = sizeof(error);
+    return poll(&fds, 1, m_timeout) > 0 &&
+           getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 &&
+           error == 0;
+  }
+
+  std::string m_address;
+};
+
+/*!
+ * @brief Unix domain stream socket, named pipe or recorded file
+ */
+class PathChannel : public DescriptorChannel {
+ public:
+  enum Type {
+    TYPE_UNIX,
+    TYPE_PIPE,
+    TYPE_FILE,
+  };
+
+  PathChannel(Type type, const std::string &path, bool loop, bool fast,
+              uint32_t baudrate, uint32_t timeout)
+    : DescriptorChannel(type == TYPE_FILE ? KIND_FILE : KIND_STREAM,
+                        fast ? 0 : baudrate, timeout),
+      m_type(type), m_path(path) {
+    m_loop = loop;
+    //nobody answers a recording, and a pipe only carries data one way.
+    m_writable = type == TYPE_UNIX;
+  }
+
+  virtual bool open() {
+    if (isOpen()) {
+      return true;
+    }
+
+    if (m_type != TYPE_UNIX) {
+      //O_RDWR keeps a named pipe open while its writer comes and goes.
+      return attach(::open(m_path.c_str(),
+                           m_type == TYPE_PIPE ? O_RDWR : O_RDONLY));
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (m_path.size() >= sizeof(address.sun_path)) {
+      fprintf(stderr, "Unix socket path too long: %s\n", m_path.c_str());
+      return false;
+    }
+
+    strncpy(address.sun_path, m_path.c_str(), sizeof(address.sun_path) - 1);
+
+    if (!attach(socket(AF_UNIX, SOCK_STREAM, 0))) {
+      return false;
+    }
+
+    //connecting a local socket never blocks for long.
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_NONBLOCK);
+    bool ok = connect(m_fd, reinterpret_cast<sockaddr *>(&address),
+                      sizeof(address)) == 0;
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+
+    if (!ok) {
+      closeDescriptor();
+    }
+
+    return ok;
+  }
+
+ private:
+  Type m_type;
+  std::string m_path;
+};
+
+/*!
+ * @brief whether "a&b&c" lists name
+ */
+bool hasOption(const std::string &query, const std::string &name) {
+  size_t begin = 0;
+
+  while (begin <= query.size()) {
+    size_t end = query.find('&', begin);
+
+    if (end == std::string::npos) {
+      end = query.size();
+    }
+
+    if (query.compare(begin, end - begin, name) == 0) {
+      return true;
+    }
+
+    begin = end + 1;
+  }
+
+  return false;
+}
+
+#endif
+
+}
+
+ChannelDevice *ChannelDevice::create(const std::string &port,
+                                     uint32_t baudrate, uint32_t timeout) {
+  if (!isUri(port)) {
+    return new SerialChannel(port, baudrate, timeout);
+  }
+
+  size_t pos = port.find("://");
+  std::string scheme = port.substr(0, pos);
+  std::string address = port.substr(pos + 3);
+  std::string query;
+  pos = address.find('?');
+
+  if (pos != std::string::npos) {
+    query = address.substr(pos + 1);
+    address = address.substr(0, pos);
+  }
+
+#if !defined(_WIN32)
+
+  if (scheme == "tcp" || scheme == "udp") {
+    return new SocketChannel(scheme == "udp", address, baudrate, timeout);
+  }
+
+  if (scheme == "unix") {
+    return new PathChannel(PathChannel::TYPE_UNIX, address, false, false,
+                           baudrate, timeout);
+  }
+
+  if (scheme == "pipe") {
+    return new PathChannel(PathChannel::TYPE_PIPE, address, false, false,
+                           baudrate, timeout);
+  }
+
+  if (scheme == "file") {
+    return new PathChannel(PathChannel::TYPE_FILE, address,
+                           hasOption(query, "loop"), hasOption(query, "fast"),
+                           baudrate, timeout);
+  }
+
+#endif
+  fprintf(stderr, "Unsupported channel: %s\n", port.c_str());
+  return NULL;
+}
+
+}// namespace ydlidar
@@ -7,6 +7,7 @@
  * http://opensource.org/licenses/MIT
  */
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -40,7 +41,7 @@ static string dirname(const string &path);
 static bool path_exists(const string &path);
 static string realpath(const string &path);
 static string usb_sysfs_friendly_name(const string &sys_usb_path, string &device_id);
-static vector<string> get_sysfs_info(const string &device_path);
+static string usb_sysfs_path(const string &device_path);
 static string read_line(const string &file);
 static string usb_sysfs_hw_string(const string &sysfs_path);
 static string format(const char *format, ...);
@@ -143,58 +144,25 @@ usb_sysfs_friendly_name(const string &sys_usb_path, string &device_id) {
   return format("%s %s %s", manufacturer.c_str(), product.c_str(), serial.c_str());
 }
 
-vector<string>
-get_sysfs_info(const string &device_path) {
+string
+usb_sysfs_path(const string &device_path) {
   string device_name = basename(device_path);
 
-  string friendly_name;
-
-  string hardware_id;
-
-  string device_id;
-
   string sys_device_path = format("/sys/class/tty/%s/device", device_name.c_str());
 
   if (device_name.compare(0, 6, "ttyUSB") == 0) {
     sys_device_path = dirname(dirname(realpath(sys_device_path)));
-
-    if (path_exists(sys_device_path)) {
-      friendly_name = usb_sysfs_friendly_name(sys_device_path, device_id);
-
-      hardware_id = usb_sysfs_hw_string(sys_device_path);
-    }
   } else if (device_name.compare(0, 6, "ttyACM") == 0) {
     sys_device_path = dirname(realpath(sys_device_path));
-
-    if (path_exists(sys_device_path)) {
-      friendly_name = usb_sysfs_friendly_name(sys_device_path, device_id);
-
-      hardware_id = usb_sysfs_hw_string(sys_device_path);
-    }
   } else {
-    // Try to read ID string of PCI device
-
-    string sys_id_path = sys_device_path + "/id";
-
-    if (path_exists(sys_id_path)) {
-      hardware_id = read_line(sys_id_path);
-    }
-  }
-
-  if (friendly_name.empty()) {
-    friendly_name = device_name;
+    return "";
   }
 
-  if (hardware_id.empty()) {
-    hardware_id = "n/a";
+  if (!path_exists(sys_device_path + "/idVendor")) {
+    return "";
   }
 
-  vector<string> result;
-  result.push_back(friendly_name);
-  result.push_back(hardware_id);
-  result.push_back(device_id);
-
-  return result;
+  return sys_device_path;
 }
 
 string
@@ -281,14 +249,20 @@ usb_sysfs_hw_string(const string &sysfs_path) {
 
 vector<PortInfo>
 serial::list_ports() {
+  vector<string> vid_pids;
+  vid_pids.push_back("10c4:ea60");
+  vid_pids.push_back("0483:5740");
+  return list_ports(vid_pids);
+}
+
+vector<PortInfo>
+serial::list_ports(const vector<string> &vid_pids, const string &serial_number) {
   vector<PortInfo> results;
 
+  // Only USB serial adapters have a VID:PID, on-board ttyS ports never match.
   vector<string> search_globs;
   search_globs.push_back("/dev/ttyACM*");
-  search_globs.push_back("/dev/ttyS*");
   search_globs.push_back("/dev/ttyUSB*");
-  search_globs.push_back("/dev/tty.*");
-  search_globs.push_back("/dev/cu.*");
 
   vector<string> devices_found = glob(search_globs);
 
@@ -297,29 +271,40 @@ serial::list_ports() {
   while (iter != devices_found.end()) {
     string device = *iter++;
 
-    vector<string> sysfs_info = get_sysfs_info(device);
-
-    string friendly_name = sysfs_info[0];
+    string sys_usb_path = usb_sysfs_path(device);
 
-    string hardware_id = sysfs_info[1];
+    if (sys_usb_path.empty()) {
+      continue;
+    }
 
-    string device_id = sysfs_info[2];
+    string vid_pid = format("%s:%s",
+                            read_line(sys_usb_path + "/idVendor").c_str(),
+                            read_line(sys_usb_path + "/idProduct").c_str());
 
-    std::size_t found = hardware_id.find("10c4:ea60");
-    std::size_t found1 = hardware_id.find("0483:5740");
+    if (!vid_pids.empty() &&
+        std::find(vid_pids.begin(), vid_pids.end(), vid_pid) == vid_pids.end()) {
+      continue;
+    }
 
+    string serial = read_line(sys_usb_path + "/serial");
 
-    if (found != std::string::npos || found1 != std::string::npos) {
-      PortInfo device_entry;
-      device_entry.port = device;
-      device_entry.description = friendly_name;
-      device_entry.hardware_id = hardware_id;
-      device_entry.device_id = device_id;
-      results.push_back(device_entry);
+    if (!serial_number.empty() && serial != serial_number) {
+      continue;
     }
 
+    PortInfo device_entry;
+    device_entry.port = device;
+    device_entry.description = usb_sysfs_friendly_name(sys_usb_path,
+                               device_entry.device_id);
 
+    if (device_entry.description.empty()) {
+      device_entry.description = basename(device);
+    }
 
+    device_entry.hardware_id = usb_sysfs_hw_string(sys_usb_path);
+    device_entry.serial_number = serial;
+    device_entry.usb_path = basename(sys_usb_path);
+    results.push_back(device_entry);
   }
 
   return results;
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <sstream>
+#include <algorithm>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -640,7 +641,7 @@ Serial::SerialImpl::SerialImpl(const string &port, unsigned long baudrate,
                                bytesize_t bytesize,
                                parity_t parity, stopbits_t stopbits,
                                flowcontrol_t flowcontrol)
-  : port_(port), fd_(-1), is_open_(false), xonxoff_(false), rtscts_(false),
+  : port_(port), fd_(-1), wakeup_fd_(-1), is_open_(false), xonxoff_(false), rtscts_(false),
     baudrate_(baudrate), parity_(parity),
     bytesize_(bytesize), stopbits_(stopbits), flowcontrol_(flowcontrol) {
   pthread_mutex_init(&this->read_mutex, NULL);
@@ -818,14 +819,7 @@ int Serial::SerialImpl::waitfordata(size_t data_count, uint32_t timeout,
   fd_set input_set;
   struct timeval timeout_val;
 
-  /* Initialize the input set */
-  FD_ZERO(&input_set);
-  FD_SET(fd_, &input_set);
-  max_fd = fd_ + 1;
-
-  /* Initialize the timeout structure */
-  timeout_val.tv_sec = timeout / 1000;
-  timeout_val.tv_usec = (timeout % 1000) * 1000;
+  max_fd = std::max(fd_, wakeup_fd_) + 1;
 
   if (is_open_) {
     if (ioctl(fd_, FIONREAD, returned_size) == -1) {
@@ -847,6 +841,18 @@ int Serial::SerialImpl::waitfordata(size_t data_count, uint32_t timeout,
       return -1;
     }
 
+    /* Initialize the input set */
+    FD_ZERO(&input_set);
+    FD_SET(fd_, &input_set);
+
+    if (wakeup_fd_ >= 0) {
+      FD_SET(wakeup_fd_, &input_set);
+    }
+
+    /* Initialize the timeout structure */
+    timeout_val.tv_sec = timeout_remaining_ms / 1000;
+    timeout_val.tv_usec = (timeout_remaining_ms % 1000) * 1000;
+
     /* Do the select */
     int n = ::select(max_fd, &input_set, NULL, NULL, &timeout_val);
 
@@ -860,6 +866,9 @@ int Serial::SerialImpl::waitfordata(size_t data_count, uint32_t timeout,
     } else if (n == 0) {
       // time out
       return -1;
+    } else if (wakeup_fd_ >= 0 && FD_ISSET(wakeup_fd_, &input_set)) {
+      // woken up by the owner
+      return -1;
     } else {
       // data avaliable
       assert(FD_ISSET(fd_, &input_set));
@@ -871,12 +880,23 @@ int Serial::SerialImpl::waitfordata(size_t data_count, uint32_t timeout,
       if (*returned_size >= data_count) {
         return 0;
       } else {
-        int remain_timeout = timeout_val.tv_sec * 1000000 + timeout_val.tv_usec;
-        int expect_remain_time = (data_count - *returned_size) * 1000000 * 8 /
-                                 baudrate_;
+        int64_t remain_timeout = total_timeout.remaining() * 1000;
+        int64_t expect_remain_time = (data_count - *returned_size) * 1000000LL * 8 /
+                                     baudrate_;
 
         if (remain_timeout > expect_remain_time) {
-          usleep(expect_remain_time);
+          // sleep until the rest should have arrived, unless woken up.
+          timeout_val.tv_sec = expect_remain_time / 1000000;
+          timeout_val.tv_usec = expect_remain_time % 1000000;
+          FD_ZERO(&input_set);
+
+          if (wakeup_fd_ >= 0) {
+            FD_SET(wakeup_fd_, &input_set);
+          }
+
+          if (::select(wakeup_fd_ + 1, &input_set, NULL, NULL, &timeout_val) > 0) {
+            return -1;
+          }
         }
       }
     }
@@ -1522,6 +1542,14 @@ uint32_t Serial::SerialImpl::getByteTime() {
   return byte_time_ns_;
 }
 
+int Serial::SerialImpl::getFileDescriptor() const {
+  return is_open_ ? fd_ : -1;
+}
+
+void Serial::SerialImpl::setWakeupDescriptor(int fd) {
+  wakeup_fd_ = fd;
+}
+
 int Serial::SerialImpl::readLock() {
   int result = pthread_mutex_lock(&this->read_mutex);
   return result;
@@ -80,6 +80,10 @@ class Serial::SerialImpl {
 
   uint32_t getByteTime();
 
+  int getFileDescriptor() const;
+
+  void setWakeupDescriptor(int fd);
+
   void setPort(const string &port);
 
   string getPort() const;
@@ -128,6 +132,7 @@ class Serial::SerialImpl {
  private:
   string port_;               // Path to the file descriptor
   int fd_;                    // The current file descriptor
+  int wakeup_fd_;             // Interrupts waitfordata while readable
   pid_t pid;
 
   bool is_open_;
@@ -34,9 +34,35 @@ std::string utf8_encode(const std::wstring &wstr) {
   return strTo;
 }
 
+// VID:PID as found in a hardware ID, e.g. "10c4:ea60" -> "VID_10C4&PID_EA60"
+static std::string hardware_id_pattern(const std::string &vid_pid) {
+  std::string vid = vid_pid.substr(0, vid_pid.find(':'));
+  std::string pid = vid_pid.substr(vid_pid.find(':') + 1);
+  std::string pattern = "VID_" + vid + "&PID_" + pid;
+
+  for (size_t i = 0; i < pattern.size(); i++) {
+    pattern[i] = toupper(pattern[i]);
+  }
+
+  return pattern;
+}
+
 vector<PortInfo>
 serial::list_ports() {
+  vector<string> vid_pids;
+  vid_pids.push_back("10c4:ea60");
+  vid_pids.push_back("0483:5740");
+  return list_ports(vid_pids);
+}
+
+vector<PortInfo>
+serial::list_ports(const vector<string> &vid_pids, const string &serial_number) {
   vector<PortInfo> devices_found;
+  vector<string> patterns;
+
+  for (size_t i = 0; i < vid_pids.size(); i++) {
+    patterns.push_back(hardware_id_pattern(vid_pids[i]));
+  }
 
   HDEVINFO device_info_set = SetupDiGetClassDevs(
                                (const GUID *) &GUID_DEVCLASS_PORTS,
@@ -163,6 +189,7 @@ serial::list_ports() {
     std::string hardwareId = hardware_id;
     std::string deviceId = device_id;
 #endif
+    std::string location = deviceId;
     size_t pos = deviceId.find("#");
 
     if (pos != std::string::npos) {
@@ -170,17 +197,45 @@ serial::list_ports() {
       deviceId = std::to_string(atoi(deviceId.c_str()));
     }
 
-    if (hardwareId.find("VID_10C4&PID_EA60") != std::string::npos ||
-        hardwareId.find("VID_0483&PID_5740") != std::string::npos) {
-      PortInfo port_entry;
-      port_entry.port = portName;
-      port_entry.description = friendlyName;
-      port_entry.hardware_id = hardwareId;
-      port_entry.device_id = deviceId;
-      devices_found.push_back(port_entry);
+    bool matched = patterns.empty() &&
+                   hardwareId.find("VID_") != std::string::npos;
+
+    for (size_t i = 0; i < patterns.size() && !matched; i++) {
+      matched = hardwareId.find(patterns[i]) != std::string::npos;
+    }
+
+    if (!matched) {
+      continue;
+    }
+
+    // USB\VID_10C4&PID_EA60\<serial>, generated instance IDs contain '&'
+    std::string serialNumber;
+    TCHAR instance_id[device_id_max_length];
 
+    if (SetupDiGetDeviceInstanceId(device_info_set, &device_info_data,
+                                   instance_id, device_id_max_length, NULL)) {
+      std::string instanceId = instance_id;
+      size_t sep = instanceId.rfind('\\');
+
+      if (sep != std::string::npos &&
+          instanceId.find('&', sep) == std::string::npos) {
+        serialNumber = instanceId.substr(sep + 1);
+      }
     }
 
+    if (!serial_number.empty() && serialNumber != serial_number) {
+      continue;
+    }
+
+    PortInfo port_entry;
+    port_entry.port = portName;
+    port_entry.description = friendlyName;
+    port_entry.hardware_id = hardwareId;
+    port_entry.device_id = deviceId;
+    port_entry.serial_number = serialNumber;
+    port_entry.usb_path = location;
+    devices_found.push_back(port_entry);
+
 
   }
 
@@ -960,6 +960,14 @@ uint32_t Serial::SerialImpl::getByteTime() {
   return byte_time_ns_;
 }
 
+int Serial::SerialImpl::getFileDescriptor() const {
+  return -1;
+}
+
+void Serial::SerialImpl::setWakeupDescriptor(int fd) {
+  (void)fd;
+}
+
 
 int Serial::SerialImpl::readLock() {
   if (WaitForSingleObject(read_mutex, INFINITE) != WAIT_OBJECT_0) {
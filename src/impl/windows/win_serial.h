@@ -79,6 +79,10 @@ class Serial::SerialImpl {
 
   uint32_t getByteTime();
 
+  int getFileDescriptor() const;
+
+  void setWakeupDescriptor(int fd);
+
   void setPort(const string &port);
 
   string getPort() const;
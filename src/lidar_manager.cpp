@@ -0,0 +1,390 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+#include "lidar_manager.h"
+#include <chrono>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const uint32_t kWakeupId = 0xFFFFFFFF;
+}
+
+struct LidarManager::Worker {
+  Worker() : manager(NULL), index(0), epfd(-1) {}
+
+  LidarManager *manager;
+  size_t        index;    ///< devices with id % workers == index
+  int           epfd;
+  PollEvent     wakeup;   ///< interrupts epoll_wait on stop
+  Thread        thread;
+  LaserScan     scan;     ///< reused for every scan of this worker
+};
+
+LidarManager::LidarManager(int workers) {
+  m_running = false;
+  m_startTimeout = 0;
+
+  if (workers < 1) {
+    workers = 1;
+  }
+
+  for (int i = 0; i < workers; i++) {
+    Worker *worker = new Worker();
+    worker->manager = this;
+    worker->index = m_workers.size();
+    m_workers.push_back(worker);
+  }
+}
+
+LidarManager::~LidarManager() {
+  stop();
+
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    delete m_workers[i];
+  }
+
+  m_workers.clear();
+
+  for (size_t i = 0; i < m_lidars.size(); i++) {
+    delete m_lidars[i];
+  }
+
+  m_lidars.clear();
+}
+
+int LidarManager::addLidar(CYdLidar *lidar) {
+  if (m_running || !lidar) {
+    return -1;
+  }
+
+  lidar->setThreadless(true);
+  m_lidars.push_back(lidar);
+  return static_cast<int>(m_lidars.size() - 1);
+}
+
+CYdLidar *LidarManager::getLidar(int id) const {
+  if (id < 0 || id >= static_cast<int>(m_lidars.size())) {
+    return NULL;
+  }
+
+  return m_lidars[id];
+}
+
+size_t LidarManager::getLidarCount() const {
+  return m_lidars.size();
+}
+
+void LidarManager::setScanCallback(const ScanCallback &callback) {
+  m_scanCallback = callback;
+}
+
+void LidarManager::setErrorCallback(const ErrorCallback &callback) {
+  m_errorCallback = callback;
+}
+
+void LidarManager::setStartTimeout(uint32_t timeout) {
+  m_startTimeout = timeout;
+}
+
+LidarManager::StartResult LidarManager::getStartResult(int id) const {
+  if (id < 0 || id >= static_cast<int>(m_results.size())) {
+    return START_FAILED;
+  }
+
+  return m_results[id];
+}
+
+size_t LidarManager::startAll(const std::vector<CYdLidar *> &lidars,
+                              uint32_t timeout,
+                              std::vector<StartResult> &results) {
+  std::chrono::steady_clock::time_point deadline =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  std::vector<std::shared_future<bool> > futures;
+
+  for (size_t i = 0; i < lidars.size(); i++) {
+    lidars[i]->initializeAsync();
+    futures.push_back(lidars[i]->turnOnAsync());
+  }
+
+  size_t started = 0;
+  results.assign(lidars.size(), START_FAILED);
+
+  for (size_t i = 0; i < futures.size(); i++) {
+    if (timeout &&
+        futures[i].wait_until(deadline) != std::future_status::ready) {
+      fprintf(stderr, "[LidarManager] Timed out bringing up LiDAR[%s]\n",
+              lidars[i]->getSerialPort().c_str());
+      fflush(stderr);
+      results[i] = START_TIMEOUT;
+      continue;
+    }
+
+    if (futures[i].get()) {
+      results[i] = START_OK;
+      started++;
+    }
+  }
+
+  return started;
+}
+
+bool LidarManager::isRunning() const {
+  return m_running;
+}
+
+bool LidarManager::start() {
+#ifdef __linux__
+
+  if (m_running) {
+    return true;
+  }
+
+  bool ret = true;
+
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    Worker *worker = m_workers[i];
+    worker->epfd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (worker->epfd < 0) {
+      fprintf(stderr, "[LidarManager] Failed to create epoll: %s\n",
+              strerror(errno));
+      fflush(stderr);
+      stop();
+      return false;
+    }
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = kWakeupId;
+    epoll_ctl(worker->epfd, EPOLL_CTL_ADD, worker->wakeup.fd(), &ev);
+  }
+
+  startAll(m_lidars, m_startTimeout, m_results);
+
+  for (size_t id = 0; id < m_lidars.size(); id++) {
+    CYdLidar *lidar = m_lidars[id];
+
+    if (m_results[id] != START_OK) {
+      fprintf(stderr, "[LidarManager] Failed to start LiDAR %d[%s]\n",
+              static_cast<int>(id), lidar->getSerialPort().c_str());
+      fflush(stderr);
+      ret = false;
+      continue;
+    }
+
+    Worker *worker = m_workers[id % m_workers.size()];
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(id);
+
+    if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, lidar->getFileDescriptor(),
+                  &ev) != 0) {
+      fprintf(stderr, "[LidarManager] Failed to watch LiDAR %d: %s\n",
+              static_cast<int>(id), strerror(errno));
+      fflush(stderr);
+      lidar->turnOff();
+      m_results[id] = START_FAILED;
+      ret = false;
+      continue;
+    }
+
+    //from now on only the worker reads the port.
+    lidar->setExternalLoop(true);
+  }
+
+  m_running = true;
+
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    Worker *worker = m_workers[i];
+    worker->thread = Thread::createThread(workerProc, worker);
+
+    if (worker->thread.getHandle() == 0) {
+      fprintf(stderr, "[LidarManager] Failed to create worker thread\n");
+      fflush(stderr);
+      stop();
+      return false;
+    }
+  }
+
+  return ret;
+#else
+  fprintf(stderr, "[LidarManager] epoll is not available on this platform\n");
+  fflush(stderr);
+  return false;
+#endif
+}
+
+void LidarManager::stop() {
+#ifdef __linux__
+  bool running = m_running;
+  m_running = false;
+
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    Worker *worker = m_workers[i];
+
+    if (running && worker->thread.getHandle() != 0) {
+      //let the loop finish its current device before reaping the thread.
+      worker->wakeup.set();
+
+      if (worker->thread.join(1000) == -1) {
+        //it serves devices that are turned off next, never abandon it.
+        fprintf(stderr, "[LidarManager] worker %d did not exit within 1000 ms, "
+                "still waiting\n", static_cast<int>(worker->index));
+        fflush(stderr);
+        worker->thread.join();
+      }
+
+      worker->thread = Thread();
+    }
+
+    worker->wakeup.clear();
+
+    if (worker->epfd >= 0) {
+      close(worker->epfd);
+      worker->epfd = -1;
+    }
+  }
+
+#endif
+
+  for (size_t i = 0; i < m_lidars.size(); i++) {
+    //a device that timed out may still be bringing itself up.
+    m_lidars[i]->waitAsync();
+    m_lidars[i]->setExternalLoop(false);
+    m_lidars[i]->turnOff();
+    m_lidars[i]->disconnecting();
+  }
+}
+
+_size_t THREAD_PROC LidarManager::workerProc(void *param) {
+  Worker *worker = static_cast<Worker *>(param);
+  return worker->manager->runWorker(worker);
+}
+
+int LidarManager::runWorker(Worker *worker) {
+#ifdef __linux__
+  epoll_event events[16];
+
+  while (m_running) {
+    //wake up in time to notice the quickest stall among our devices.
+    int timeout = -1;
+
+    for (size_t id = worker->index; id < m_lidars.size();
+         id += m_workers.size()) {
+      if (m_results[id] != START_OK) {
+        continue;
+      }
+
+      int dataTimeout = static_cast<int>(m_lidars[id]->getDataTimeout());
+
+      if (timeout < 0 || dataTimeout < timeout) {
+        timeout = dataTimeout;
+      }
+    }
+
+    int n = epoll_wait(worker->epfd, events, _countof(events), timeout);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      fprintf(stderr, "[LidarManager] epoll_wait failed: %s\n", strerror(errno));
+      fflush(stderr);
+      break;
+    }
+
+    for (int i = 0; i < n && m_running; i++) {
+      if (events[i].data.u32 == kWakeupId) {
+        continue;
+      }
+
+      handleReadable(worker, static_cast<int>(events[i].data.u32),
+                     events[i].events);
+    }
+
+    for (size_t id = worker->index; id < m_lidars.size() && m_running;
+         id += m_workers.size()) {
+      if (m_results[id] == START_OK) {
+        m_lidars[id]->checkWatchdog();
+      }
+    }
+  }
+
+#endif
+  return 0;
+}
+
+void LidarManager::handleReadable(Worker *worker, int id, uint32_t events) {
+#ifdef __linux__
+  CYdLidar *lidar = m_lidars[id];
+  size_t scans = 0;
+
+  if ((events & (EPOLLERR | EPOLLHUP)) || !lidar->processReadable(&scans)) {
+    fprintf(stderr, "[LidarManager] LiDAR %d[%s] stopped responding\n", id,
+            lidar->getSerialPort().c_str());
+    fflush(stderr);
+    epoll_ctl(worker->epfd, EPOLL_CTL_DEL, lidar->getFileDescriptor(), NULL);
+    lidar->setExternalLoop(false);
+    //no more watchdog checks on a device that is gone, and no reconnect:
+    //it stays down until the next start.
+    m_results[id] = START_FAILED;
+
+    if (m_errorCallback) {
+      m_errorCallback(id);
+    }
+
+    return;
+  }
+
+  if (scans == 0) {
+    return;
+  }
+
+  //the driver keeps the latest scan only; any earlier one of this read is
+  //already counted as overwritten.
+  bool hardwareError = false;
+
+  if (lidar->doProcessSimple(worker->scan, hardwareError) && m_scanCallback) {
+    m_scanCallback(id, worker->scan);
+  }
+
+#else
+  UNUSED(worker);
+  UNUSED(id);
+  UNUSED(events);
+#endif
+}
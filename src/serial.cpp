@@ -356,4 +356,12 @@ bool Serial::getCD() {
 int Serial::getByteTime() {
   return pimpl_->getByteTime();
 }
+
+int Serial::getFileDescriptor() {
+  return pimpl_->getFileDescriptor();
+}
+
+void Serial::setWakeupDescriptor(int fd) {
+  pimpl_->setWakeupDescriptor(fd);
+}
 }
@@ -33,13 +33,31 @@
 *********************************************************************/
 #include "ydlidar_driver.h"
 #include "common.h"
+#include "port_table.h"
 #include <math.h>
 using namespace impl;
 
 namespace ydlidar {
 
+//! drop bytes already received
+static void discardData(ChannelDevice *comm, size_t size) {
+  uint8_t buffer[512];
+
+  while (size > 0) {
+    size_t r = comm->readData(buffer, std::min(size, sizeof(buffer)));
+
+    if (r == 0) {
+      break;
+    }
+
+    size -= r;
+  }
+}
+
 YDlidarDriver::YDlidarDriver():
-  _serial(NULL) {
+  _cancelEvent(false),
+  _comm(NULL),
+  motor_event(false) {
   isConnected         = false;
   isScanning          = false;
   //串口配置参数
@@ -49,6 +67,7 @@ YDlidarDriver::YDlidarDriver():
   m_baudrate          = 230400;
   isSupportMotorDtrCtrl  = true;
   scan_node_count     = 0;
+  memset(&scan_stats, 0, sizeof(scan_stats));
   sample_rate         = 5000;
   m_PointTime         = 1e9 / 5000;
   trans_delay         = 0;
@@ -87,6 +106,26 @@ YDlidarDriver::YDlidarDriver():
   scan_node_buf = new node_info[MAX_SCAN_NODES];
   package_index = 0;
   has_package_error = false;
+  m_ScanSeamAngle = -1.f;
+  seam_armed = false;
+  seam_last_offset = 0.f;
+  seam_scan_frequence = 0;
+  last_package_time = 0;
+  max_package_samples = 0;
+  last_ring_time = 0;
+  ring_interval = 0;
+  ring_frequence = 0;
+  stable_rings = 0;
+  motor_ready = false;
+  scan_paused = false;
+  data_stalled = false;
+  reconnect_count = 0;
+  m_Threadless = false;
+  m_ExternalLoop = false;
+  package_recvPos = 0;
+  package_Sample_Num = 0;
+  local_scan = new node_info[MAX_SCAN_NODES];
+  local_scan_count = 0;
 }
 
 YDlidarDriver::~YDlidarDriver() {
@@ -95,20 +134,22 @@ YDlidarDriver::~YDlidarDriver() {
   }
 
   isAutoReconnect = false;
-  _thread.join();
+  _wakeup.set();
+  _cancelEvent.set();
+  joinThread();
 
   ScopedLocker lk(_serial_lock);
 
-  if (_serial) {
-    if (_serial->isOpen()) {
-      _serial->flush();
-      _serial->closePort();
+  if (_comm) {
+    if (_comm->isOpen()) {
+      _comm->flush();
+      _comm->closePort();
     }
   }
 
-  if (_serial) {
-    delete _serial;
-    _serial = NULL;
+  if (_comm) {
+    delete _comm;
+    _comm = NULL;
   }
 
   if (globalRecvBuffer) {
@@ -120,22 +161,45 @@ YDlidarDriver::~YDlidarDriver() {
     delete[] scan_node_buf;
     scan_node_buf = NULL;
   }
+
+  if (local_scan) {
+    delete[] local_scan;
+    local_scan = NULL;
+  }
 }
 
 result_t YDlidarDriver::connect(const char *port_path, uint32_t baudrate) {
   ScopedLocker lk(_serial_lock);
+
+  if (!IS_OK(openPort(port_path, baudrate))) {
+    return RESULT_FAIL;
+  }
+
+  stopScan();
+  delay(100);
+  clearDTR();
+
+  return RESULT_OK;
+}
+
+result_t YDlidarDriver::openPort(const char *port_path, uint32_t baudrate) {
   m_baudrate = baudrate;
   serial_port = string(port_path);
 
-  if (!_serial) {
-    _serial = new serial::Serial(port_path, m_baudrate,
-                                 serial::Timeout::simpleTimeout(DEFAULT_TIMEOUT));
+  if (!_comm) {
+    _comm = ChannelDevice::create(port_path, m_baudrate, DEFAULT_TIMEOUT);
+
+    if (!_comm) {
+      return RESULT_FAIL;
+    }
+
+    _comm->setWakeupDescriptor(_wakeup.fd());
   }
 
   {
     ScopedLocker l(_lock);
 
-    if (!_serial->open()) {
+    if (!_comm->open()) {
       return RESULT_FAIL;
     }
 
@@ -143,10 +207,6 @@ result_t YDlidarDriver::connect(const char *port_path, uint32_t baudrate) {
 
   }
 
-  stopScan();
-  delay(100);
-  clearDTR();
-
   return RESULT_OK;
 }
 
@@ -156,8 +216,8 @@ void YDlidarDriver::setDTR() {
     return ;
   }
 
-  if (_serial) {
-    _serial->setDTR(1);
+  if (_comm) {
+    _comm->setDTR(1);
   }
 
 }
@@ -167,8 +227,8 @@ void YDlidarDriver::clearDTR() {
     return ;
   }
 
-  if (_serial) {
-    _serial->setDTR(0);
+  if (_comm) {
+    _comm->setDTR(0);
   }
 }
 void YDlidarDriver::flushSerial() {
@@ -176,11 +236,7 @@ void YDlidarDriver::flushSerial() {
     return;
   }
 
-  size_t len = _serial->available();
-
-  if (len) {
-    _serial->read(len);
-  }
+  discardData(_comm, _comm->available());
 
   delay(20);
 }
@@ -197,9 +253,9 @@ void YDlidarDriver::disconnect() {
   delay(10);
   ScopedLocker l(_serial_lock);
 
-  if (_serial) {
-    if (_serial->isOpen()) {
-      _serial->closePort();
+  if (_comm) {
+    if (_comm->isOpen()) {
+      _comm->closePort();
     }
   }
 
@@ -213,8 +269,32 @@ void YDlidarDriver::disableDataGrabbing() {
     if (isScanning) {
       isScanning = false;
       _dataEvent.set();
+      _scanNotify.set();
     }
   }
+  if (!scan_paused) {
+    m_broadcast.setClosed(true);
+  }
+
+  //wake the parsing thread out of serial and reconnect waits, so it leaves
+  //on its own well before the join bound.
+  _wakeup.set();
+  _cancelEvent.set();
+  joinThread();
+  _wakeup.clear();
+  _cancelEvent.set(false);
+}
+
+void YDlidarDriver::joinThread() {
+  if (_thread.join(DEFAULT_STOP_TIMEOUT) != -1) {
+    return;
+  }
+
+  //never abandon the parser: it may hold locks and uses what the caller
+  //frees next.
+  fprintf(stderr, "[YDlidarDriver] parsing thread did not exit within %d ms, "
+          "still waiting\n", DEFAULT_STOP_TIMEOUT);
+  fflush(stderr);
   _thread.join();
 }
 
@@ -227,8 +307,9 @@ bool YDlidarDriver::isconnected() const {
 
 result_t YDlidarDriver::sendCommand(uint8_t cmd, const void *payload,
                                     size_t payloadsize) {
-  uint8_t pkt_header[10];
-  cmd_packet *header = reinterpret_cast<cmd_packet * >(pkt_header);
+  //sync, cmd, size, up to 255 payload bytes and the checksum.
+  uint8_t pkt[4 + 0xFF];
+  size_t size = 0;
   uint8_t checksum = 0;
 
   if (!isConnected) {
@@ -239,25 +320,78 @@ result_t YDlidarDriver::sendCommand(uint8_t cmd, const void *payload,
     cmd |= LIDAR_CMDFLAG_HAS_PAYLOAD;
   }
 
-  header->syncByte = LIDAR_CMD_SYNC_BYTE;
-  header->cmd_flag = cmd;
-  sendData(pkt_header, 2) ;
+  pkt[size++] = LIDAR_CMD_SYNC_BYTE;
+  pkt[size++] = cmd;
 
   if ((cmd & LIDAR_CMDFLAG_HAS_PAYLOAD) && payloadsize && payload) {
+    uint8_t sizebyte = (uint8_t)(payloadsize);
     checksum ^= LIDAR_CMD_SYNC_BYTE;
     checksum ^= cmd;
-    checksum ^= (payloadsize & 0xFF);
+    checksum ^= sizebyte;
+    pkt[size++] = sizebyte;
 
-    for (size_t pos = 0; pos < payloadsize; ++pos) {
+    for (size_t pos = 0; pos < sizebyte; ++pos) {
       checksum ^= ((uint8_t *)payload)[pos];
+      pkt[size++] = ((uint8_t *)payload)[pos];
     }
 
-    uint8_t sizebyte = (uint8_t)(payloadsize);
-    sendData(&sizebyte, 1);
+    pkt[size++] = checksum;
+  }
 
-    sendData((const uint8_t *)payload, sizebyte);
+  return sendData(pkt, size);
+}
 
-    sendData(&checksum, 1);
+result_t YDlidarDriver::sendCommandBatch(const std::vector<uint8_t> &cmds,
+    size_t reply_size, std::vector<uint8_t> &replies, uint32_t timeout) {
+  result_t ans;
+  replies.clear();
+
+  if (!isConnected || m_SingleChannel) {
+    return RESULT_FAIL;
+  }
+
+  if (cmds.empty()) {
+    return RESULT_OK;
+  }
+
+  std::vector<uint8_t> pkt;
+  pkt.reserve(cmds.size() * 2);
+
+  for (size_t i = 0; i < cmds.size(); i++) {
+    pkt.push_back(LIDAR_CMD_SYNC_BYTE);
+    pkt.push_back(cmds[i]);
+  }
+
+  disableDataGrabbing();
+  flushSerial();
+  ScopedLocker l(_lock);
+
+  if ((ans = sendData(&pkt[0], pkt.size())) != RESULT_OK) {
+    return ans;
+  }
+
+  std::vector<uint8_t> data(reply_size);
+
+  for (size_t i = 0; i < cmds.size(); i++) {
+    lidar_ans_header response_header;
+
+    if ((ans = waitResponseHeader(&response_header, timeout)) != RESULT_OK) {
+      return ans;
+    }
+
+    if (response_header.type != LIDAR_ANS_TYPE_DEVINFO ||
+        response_header.size != reply_size) {
+      return RESULT_FAIL;
+    }
+
+    if (reply_size) {
+      if (waitForData(reply_size, timeout) != RESULT_OK) {
+        return RESULT_FAIL;
+      }
+
+      getData(&data[0], reply_size);
+      replies.insert(replies.end(), data.begin(), data.end());
+    }
   }
 
   return RESULT_OK;
@@ -275,7 +409,7 @@ result_t YDlidarDriver::sendData(const uint8_t *data, size_t size) {
   size_t r;
 
   while (size) {
-    r = _serial->writeData(data, size);
+    r = _comm->writeData(data, size);
 
     if (r < 1) {
       return RESULT_FAIL;
@@ -296,7 +430,7 @@ result_t YDlidarDriver::getData(uint8_t *data, size_t size) {
   size_t r;
 
   while (size) {
-    r = _serial->readData(data, size);
+    r = _comm->readData(data, size);
 
     if (r < 1) {
       return RESULT_FAIL;
@@ -384,7 +518,7 @@ result_t YDlidarDriver::waitForData(size_t data_count, uint32_t timeout,
     returned_size = (size_t *)&length;
   }
 
-  return (result_t)_serial->waitfordata(data_count, timeout, returned_size);
+  return (result_t)_comm->waitfordata(data_count, timeout, returned_size);
 }
 
 result_t YDlidarDriver::checkAutoConnecting() {
@@ -395,12 +529,12 @@ result_t YDlidarDriver::checkAutoConnecting() {
     {
       ScopedLocker l(_serial_lock);
 
-      if (_serial) {
-        if (_serial->isOpen() || isConnected) {
+      if (_comm) {
+        if (_comm->isOpen() || isConnected) {
           isConnected = false;
-          _serial->closePort();
-          delete _serial;
-          _serial = NULL;
+          _comm->closePort();
+          delete _comm;
+          _comm = NULL;
         }
       }
     }
@@ -410,18 +544,41 @@ result_t YDlidarDriver::checkAutoConnecting() {
       retryCount = 100;
     }
 
-    delay(100 * retryCount);
+    //once unplugged, reconnect the moment the node is back; the backoff
+    //sleeps only bound the wait when hotplug events are unavailable.
+    //a URI names no device node, so there is nothing to watch.
+    m_hotplug.setPath(serial_port);
+    bool watch = !ChannelDevice::isUri(serial_port) && m_hotplug.isSupported();
+
+    if (watch && !m_hotplug.isPresent()) {
+      m_hotplug.waitForChange(100 * retryCount, _wakeup.fd());
+    } else {
+      _cancelEvent.wait(100 * retryCount);
+    }
+
     int retryConnect = 0;
 
-    while (isAutoReconnect &&
-           connect(serial_port.c_str(), m_baudrate) != RESULT_OK) {
+    while (isAutoReconnect) {
+      {
+        ScopedLocker l(_serial_lock);
+
+        if (IS_OK(openPort(serial_port.c_str(), m_baudrate))) {
+          break;
+        }
+      }
+
       retryConnect++;
 
       if (retryConnect > 25) {
         retryConnect = 25;
       }
 
-      delay(200 * retryConnect);
+      //the node being recreated or made accessible by udev ends the wait.
+      if (watch) {
+        m_hotplug.waitForChange(200 * retryConnect, _wakeup.fd());
+      } else {
+        _cancelEvent.wait(200 * retryConnect);
+      }
     }
 
     if (!isAutoReconnect) {
@@ -430,7 +587,27 @@ result_t YDlidarDriver::checkAutoConnecting() {
     }
 
     if (isconnected()) {
-      delay(100);
+      //a brief link loss leaves the device scanning with the same settings,
+      //so pick its stream up again instead of restarting it.
+      if (IS_OK(resumeScan())) {
+        fprintf(stderr, "[YDlidarDriver] resumed scanning on %s\n",
+                serial_port.c_str());
+        fflush(stderr);
+        reconnect_count++;
+        isAutoconnting = false;
+        return RESULT_OK;
+      }
+
+      {
+        ScopedLocker l(_serial_lock);
+        stopScan();
+      }
+      _cancelEvent.wait(100);
+      {
+        ScopedLocker l(_serial_lock);
+        clearDTR();
+      }
+      _cancelEvent.wait(100);
       {
         ScopedLocker l(_serial_lock);
         ans = startAutoScan();
@@ -441,6 +618,7 @@ result_t YDlidarDriver::checkAutoConnecting() {
       }
 
       if (IS_OK(ans)) {
+        reconnect_count++;
         isAutoconnting = false;
         return ans;
       }
@@ -451,13 +629,36 @@ result_t YDlidarDriver::checkAutoConnecting() {
 
 }
 
+result_t YDlidarDriver::resumeScan() {
+  uint64_t lastPackage = last_package_time;
+  uint32_t timeout = getDataTimeout();
+  uint32_t startTs = getms();
+  uint32_t waitTime = 0;
+  resetScanParser();
+
+  while ((waitTime = getms() - startTs) < timeout) {
+    node_info node;
+
+    if (!IS_OK(waitPackage(&node, timeout - waitTime))) {
+      break;
+    }
+
+    //a valid checksum also proves the package format is unchanged.
+    if (last_package_time != lastPackage) {
+      resetScanParser();
+      return RESULT_OK;
+    }
+  }
+
+  resetScanParser();
+  return RESULT_TIMEOUT;
+}
+
 int YDlidarDriver::cacheScanData() {
   node_info      local_buf[128];
   size_t         count = 128;
-  node_info      local_scan[MAX_SCAN_NODES];
-  size_t         scan_count = 0;
   result_t       ans = RESULT_FAIL;
-  memset(local_scan, 0, sizeof(local_scan));
+  resetScanParser();
 
   if (m_SingleChannel) {
     waitDevicePackage();
@@ -471,9 +672,28 @@ int YDlidarDriver::cacheScanData() {
 
   while (isScanning) {
     count = 128;
-    ans = waitScanData(local_buf, count);
+    ans = waitScanData(local_buf, count, getDataTimeout());
+
+    if (!isScanning) {
+      break;
+    }
 
     if (!IS_OK(ans)) {
+      //short waits only feed the watchdog; a stall counts one timeout for
+      //every DEFAULT_TIMEOUT it lasts.
+      if (checkWatchdog()) {
+        //a revolution with a gap in it is no revolution.
+        local_scan[0].sync_flag = Node_NotSync;
+        int stalls = static_cast<int>((getTime() - last_package_time) /
+                                      (1000000ULL * DEFAULT_TIMEOUT));
+
+        if (stalls > timeout_count) {
+          timeout_count = stalls;
+          fprintf(stderr, "timout count: %d\n", timeout_count);
+          fflush(stderr);
+        }
+      }
+
       if (IS_FAIL(ans) || timeout_count > DEFAULT_TIMEOUT_COUNT) {
         if (!isAutoReconnect) {
           fprintf(stderr, "exit scanning thread!!\n");
@@ -487,50 +707,128 @@ int YDlidarDriver::cacheScanData() {
 
           if (IS_OK(ans)) {
             timeout_count = 0;
-            local_scan[0].sync_flag = Node_NotSync;
+            resetScanParser();
+            last_package_time = getTime();
           } else {
             isScanning = false;
             return RESULT_FAIL;
           }
         }
-      } else {
-        timeout_count++;
-        local_scan[0].sync_flag = Node_NotSync;
-        fprintf(stderr, "timout count: %d\n", timeout_count);
-        fflush(stderr);
       }
     } else {
       timeout_count = 0;
       retryCount = 0;
+      checkWatchdog();
     }
 
+    handleScanNodes(local_buf, count);
+  }
 
-    for (size_t pos = 0; pos < count; ++pos) {
-      if (local_buf[pos].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT) {
-        if ((local_scan[0].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT)) {
-          _lock.lock();//timeout lock, wait resource copy
-          local_scan[0].stamp = local_buf[pos].stamp;
-          local_scan[0].scan_frequence = local_buf[pos].scan_frequence;
-          memcpy(scan_node_buf, local_scan, scan_count * sizeof(node_info));
-          scan_node_count = scan_count;
-          _dataEvent.set();
-          _lock.unlock();
-        }
+  isScanning = false;
+
+  return RESULT_OK;
+}
+
+void YDlidarDriver::resetScanParser() {
+  package_recvPos = 0;
+  package_Sample_Num = 0;
+  package_Sample_Index = 0;
+  memset(local_scan, 0, MAX_SCAN_NODES * sizeof(node_info));
+  local_scan_count = 0;
+  seam_armed = false;
+  seam_last_offset = 0.f;
+}
 
-        scan_count = 0;
+size_t YDlidarDriver::handleScanNodes(node_info *nodes, size_t count) {
+  size_t scans = 0;
+
+  std::shared_ptr<ScanWindow> window = std::atomic_load(&m_window);
+
+  if (window && count > 0) {
+    window->update(nodes, count, getTime() - nodes[count - 1].stamp,
+                   m_PointTime);
+    _sectorNotify.set();
+  }
+
+  for (size_t pos = 0; pos < count; ++pos) {
+    if (m_ScanSeamAngle >= 0) {
+      //the seam node opens the revolution instead of the device sync node.
+      if (nodes[pos].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT) {
+        seam_scan_frequence = nodes[pos].scan_frequence;
+        nodes[pos].sync_flag = Node_NotSync;
       }
 
-      local_scan[scan_count++] = local_buf[pos];
+      if (isScanSeam(nodes[pos])) {
+        nodes[pos].sync_flag = Node_Sync;
+        nodes[pos].scan_frequence = seam_scan_frequence;
+        nodes[pos].stamp = nodes[count - 1].stamp +
+                           (count - 1 - pos) * m_PointTime;
+      }
+    }
+
+    if (nodes[pos].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT) {
+      if ((local_scan[0].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT)) {
+        _lock.lock();//timeout lock, wait resource copy
+        local_scan[0].stamp = nodes[pos].stamp;
+        local_scan[0].scan_frequence = nodes[pos].scan_frequence;
+        scan_stats.produced++;
 
-      if (scan_count == _countof(local_scan)) {
-        scan_count -= 1;
+        if (scan_node_count > 0) {
+          //the previous scan was never grabbed.
+          scan_stats.overwritten++;
+        }
+
+        memcpy(scan_node_buf, local_scan, local_scan_count * sizeof(node_info));
+        scan_node_count = local_scan_count;
+        _dataEvent.set();
+        _scanNotify.set();
+        _lock.unlock();
+
+        if (m_broadcast.consumerCount() > 0) {
+          m_broadcast.publish(local_scan, local_scan_count, getTime());
+        }
+
+        scans++;
       }
+
+      local_scan_count = 0;
+    }
+
+    local_scan[local_scan_count++] = nodes[pos];
+
+    if (local_scan_count == MAX_SCAN_NODES) {
+      local_scan_count -= 1;
     }
   }
 
-  isScanning = false;
+  return scans;
+}
 
-  return RESULT_OK;
+bool YDlidarDriver::isScanSeam(const node_info &node) {
+  uint16_t angle_q6 = node.angle_q6_checkbit >> LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT;
+
+  //checksum error node
+  if (node.distance_q2 == 0 && angle_q6 == 0) {
+    return false;
+  }
+
+  float offset = fmod(angle_q6 / 64.0f - m_ScanSeamAngle, 360.0f);
+
+  if (offset < 0.0f) {
+    offset += 360.0f;
+  }
+
+  bool seam = seam_armed && (offset + 180.0f < seam_last_offset);
+
+  if (seam) {
+    seam_armed = false;
+  } else if (offset >= 90.0f && offset <= 270.0f) {
+    //re-arm half a revolution away, so angle jitter around the seam is ignored.
+    seam_armed = true;
+  }
+
+  seam_last_offset = offset;
+  return seam;
 }
 
 result_t YDlidarDriver::checkDeviceInfo(uint8_t *recvBuffer, uint8_t byte,
@@ -722,219 +1020,288 @@ result_t YDlidarDriver::waitDevicePackage(uint32_t timeout) {
 }
 
 result_t YDlidarDriver::waitPackage(node_info *node, uint32_t timeout) {
-  int recvPos         = 0;
   uint32_t startTs    = getms();
   uint32_t waitTime   = 0;
-  uint8_t  *packageBuffer = (m_intensities) ? (uint8_t *)&package.package_Head :
-                            (uint8_t *)&packages.package_Head;
-  uint8_t  package_Sample_Num         = 0;
-  int32_t  AngleCorrectForDistance    = 0;
-  int  package_recvPos    = 0;
-  uint8_t package_type    = 0;
+  bool     received   = (package_Sample_Index != 0);
 
-  if (package_Sample_Index == 0) {
-    recvPos = 0;
+  while (!received && (waitTime = getms() - startTs) <= timeout) {
+    size_t remainSize   = packageRemainSize();
+    size_t recvSize     = 0;
+    result_t ans = waitForData(remainSize, timeout - waitTime, &recvSize);
 
-    while ((waitTime = getms() - startTs) <= timeout) {
-      size_t remainSize   = PackagePaidBytes - recvPos;
-      size_t recvSize     = 0;
-      result_t ans = waitForData(remainSize, timeout - waitTime, &recvSize);
+    if (!IS_OK(ans)) {
+      return ans;
+    }
 
-      if (!IS_OK(ans)) {
-        return ans;
-      }
+    if (recvSize > remainSize) {
+      recvSize = remainSize;
+    }
+
+    getData(globalRecvBuffer, recvSize);
 
-      if (recvSize > remainSize) {
-        recvSize = remainSize;
+    for (size_t pos = 0; pos < recvSize; ++pos) {
+      if (parsePackageByte(globalRecvBuffer[pos])) {
+        received = true;
       }
+    }
+  }
 
-      getData(globalRecvBuffer, recvSize);
+  if (!received) {
+    return RESULT_TIMEOUT;
+  }
 
-      for (size_t pos = 0; pos < recvSize; ++pos) {
-        uint8_t currentByte = globalRecvBuffer[pos];
+  parsePackageNode(node);
+  return RESULT_OK;
+}
 
-        switch (recvPos) {
-          case 0:
-            if (currentByte == (PH & 0xFF)) {
+size_t YDlidarDriver::packageRemainSize() const {
+  if (package_recvPos < PackagePaidBytes) {
+    return PackagePaidBytes - package_recvPos;
+  }
 
-            } else {
-              continue;
-            }
+  return PackagePaidBytes + package_Sample_Num * PackageSampleBytes -
+         package_recvPos;
+}
 
-            break;
+bool YDlidarDriver::parsePackageByte(uint8_t currentByte) {
+  uint8_t  *packageBuffer = (m_intensities) ? (uint8_t *)&package.package_Head :
+                            (uint8_t *)&packages.package_Head;
+  uint8_t package_type    = 0;
 
-          case 1:
-            CheckSumCal = PH;
+  if (package_recvPos < PackagePaidBytes) {
+    switch (package_recvPos) {
+      case 0:
+        if (currentByte != (PH & 0xFF)) {
+          return false;
+        }
 
-            if (currentByte == (PH >> 8)) {
+        break;
 
-            } else {
-              recvPos = 0;
-              continue;
-            }
+      case 1:
+        CheckSumCal = PH;
 
-            break;
+        if (currentByte != (PH >> 8)) {
+          package_recvPos = 0;
+          return false;
+        }
 
-          case 2:
-            SampleNumlAndCTCal = currentByte;
-            package_type = currentByte & 0x01;
+        break;
 
-            if ((package_type == CT_Normal) || (package_type == CT_RingStart)) {
-              if (package_type == CT_RingStart) {
-                scan_frequence = (currentByte & 0xFE) >> 1;
-              }
-            } else {
-              has_package_error = true;
-              recvPos = 0;
-              continue;
-            }
+      case 2:
+        SampleNumlAndCTCal = currentByte;
+        package_type = currentByte & 0x01;
 
-            break;
+        if ((package_type == CT_Normal) || (package_type == CT_RingStart)) {
+          if (package_type == CT_RingStart) {
+            scan_frequence = (currentByte & 0xFE) >> 1;
+          }
+        } else {
+          has_package_error = true;
+          package_recvPos = 0;
+          return false;
+        }
 
-          case 3:
-            SampleNumlAndCTCal += (currentByte * 0x100);
-            package_Sample_Num = currentByte;
-            break;
+        break;
 
-          case 4:
-            if (currentByte & LIDAR_RESP_MEASUREMENT_CHECKBIT) {
-              FirstSampleAngle = currentByte;
-            } else {
-              has_package_error = true;
-              recvPos = 0;
-              continue;
-            }
+      case 3:
+        SampleNumlAndCTCal += (currentByte * 0x100);
+        package_Sample_Num = currentByte;
+        break;
 
-            break;
+      case 4:
+        if (currentByte & LIDAR_RESP_MEASUREMENT_CHECKBIT) {
+          FirstSampleAngle = currentByte;
+        } else {
+          has_package_error = true;
+          package_recvPos = 0;
+          return false;
+        }
 
-          case 5:
-            FirstSampleAngle += currentByte * 0x100;
-            CheckSumCal ^= FirstSampleAngle;
-            FirstSampleAngle = FirstSampleAngle >> 1;
-            break;
+        break;
 
-          case 6:
-            if (currentByte & LIDAR_RESP_MEASUREMENT_CHECKBIT) {
-              LastSampleAngle = currentByte;
-            } else {
-              has_package_error = true;
-              recvPos = 0;
-              continue;
-            }
+      case 5:
+        FirstSampleAngle += currentByte * 0x100;
+        CheckSumCal ^= FirstSampleAngle;
+        FirstSampleAngle = FirstSampleAngle >> 1;
+        break;
 
-            break;
+      case 6:
+        if (currentByte & LIDAR_RESP_MEASUREMENT_CHECKBIT) {
+          LastSampleAngle = currentByte;
+        } else {
+          has_package_error = true;
+          package_recvPos = 0;
+          return false;
+        }
+
+        break;
 
-          case 7:
-            LastSampleAngle = currentByte * 0x100 + LastSampleAngle;
-            LastSampleAngleCal = LastSampleAngle;
-            LastSampleAngle = LastSampleAngle >> 1;
+      case 7:
+        LastSampleAngle = currentByte * 0x100 + LastSampleAngle;
+        LastSampleAngleCal = LastSampleAngle;
+        LastSampleAngle = LastSampleAngle >> 1;
 
-            if (package_Sample_Num == 1) {
-              IntervalSampleAngle = 0;
+        if (package_Sample_Num == 1) {
+          IntervalSampleAngle = 0;
+        } else {
+          if (LastSampleAngle < FirstSampleAngle) {
+            if ((FirstSampleAngle > 270 * 64) && (LastSampleAngle < 90 * 64)) {
+              IntervalSampleAngle = (float)((360 * 64 + LastSampleAngle -
+                                             FirstSampleAngle) / ((
+                                                   package_Sample_Num - 1) * 1.0));
+              IntervalSampleAngle_LastPackage = IntervalSampleAngle;
             } else {
-              if (LastSampleAngle < FirstSampleAngle) {
-                if ((FirstSampleAngle > 270 * 64) && (LastSampleAngle < 90 * 64)) {
-                  IntervalSampleAngle = (float)((360 * 64 + LastSampleAngle -
-                                                 FirstSampleAngle) / ((
-                                                       package_Sample_Num - 1) * 1.0));
-                  IntervalSampleAngle_LastPackage = IntervalSampleAngle;
-                } else {
-                  IntervalSampleAngle = IntervalSampleAngle_LastPackage;
-                }
-              } else {
-                IntervalSampleAngle = (float)((LastSampleAngle - FirstSampleAngle) / ((
-                                                package_Sample_Num - 1) * 1.0));
-                IntervalSampleAngle_LastPackage = IntervalSampleAngle;
-              }
+              IntervalSampleAngle = IntervalSampleAngle_LastPackage;
             }
+          } else {
+            IntervalSampleAngle = (float)((LastSampleAngle - FirstSampleAngle) / ((
+                                            package_Sample_Num - 1) * 1.0));
+            IntervalSampleAngle_LastPackage = IntervalSampleAngle;
+          }
+        }
 
-            break;
+        break;
 
-          case 8:
-            CheckSum = currentByte;
-            break;
+      case 8:
+        CheckSum = currentByte;
+        break;
 
-          case 9:
-            CheckSum += (currentByte * 0x100);
-            break;
-        }
+      case 9:
+        CheckSum += (currentByte * 0x100);
+        break;
+    }
 
-        packageBuffer[recvPos++] = currentByte;
-      }
+    packageBuffer[package_recvPos++] = currentByte;
 
-      if (recvPos  == PackagePaidBytes) {
-        package_recvPos = recvPos;
-        break;
+    if (package_recvPos < PackagePaidBytes || package_Sample_Num > 0) {
+      return false;
+    }
+  } else {
+    int recvPos = package_recvPos - PackagePaidBytes;
+
+    if (m_intensities) {
+      if (recvPos % 3 == 2) {
+        Valu8Tou16 += currentByte * 0x100;
+        CheckSumCal ^= Valu8Tou16;
+      } else if (recvPos % 3 == 1) {
+        Valu8Tou16 = currentByte;
+      } else {
+        CheckSumCal ^= currentByte;
+      }
+    } else {
+      if (recvPos % 2 == 1) {
+        Valu8Tou16 += currentByte * 0x100;
+        CheckSumCal ^= Valu8Tou16;
+      } else {
+        Valu8Tou16 = currentByte;
       }
     }
 
-    if (PackagePaidBytes == recvPos) {
-      startTs = getms();
-      recvPos = 0;
+    packageBuffer[package_recvPos++] = currentByte;
 
-      while ((waitTime = getms() - startTs) <= timeout) {
-        size_t remainSize = package_Sample_Num * PackageSampleBytes - recvPos;
-        size_t recvSize = 0;
-        result_t ans = waitForData(remainSize, timeout - waitTime, &recvSize);
+    if (package_recvPos < PackagePaidBytes + package_Sample_Num *
+        PackageSampleBytes) {
+      return false;
+    }
+  }
 
-        if (!IS_OK(ans)) {
-          return ans;
-        }
+  //a whole package has been received
+  package_recvPos = 0;
+  CheckSumCal ^= SampleNumlAndCTCal;
+  CheckSumCal ^= LastSampleAngleCal;
 
-        if (recvSize > remainSize) {
-          recvSize = remainSize;
-        }
+  if (CheckSumCal != CheckSum) {
+    CheckSumResult = false;
+    has_package_error = true;
+  } else {
+    CheckSumResult = true;
+    //ring start packages carry a single sample, size on the full ones.
+    if (package_Sample_Num > max_package_samples) {
+      max_package_samples = package_Sample_Num;
+    }
 
-        getData(globalRecvBuffer, recvSize);
+    last_package_time = getTime();
 
-        for (size_t pos = 0; pos < recvSize; ++pos) {
-          if (m_intensities) {
-            if (recvPos % 3 == 2) {
-              Valu8Tou16 += globalRecvBuffer[pos] * 0x100;
-              CheckSumCal ^= Valu8Tou16;
-            } else if (recvPos % 3 == 1) {
-              Valu8Tou16 = globalRecvBuffer[pos];
-            } else {
-              CheckSumCal ^= globalRecvBuffer[pos];
-            }
-          } else {
-            if (recvPos % 2 == 1) {
-              Valu8Tou16 += globalRecvBuffer[pos] * 0x100;
-              CheckSumCal ^= Valu8Tou16;
-            } else {
-              Valu8Tou16 = globalRecvBuffer[pos];
-            }
-          }
+    if ((SampleNumlAndCTCal & 0x01) == CT_RingStart) {
+      trackMotorSpeed(last_package_time);
+    }
+  }
 
-          packageBuffer[package_recvPos + recvPos] = globalRecvBuffer[pos];
-          recvPos++;
-        }
+  return true;
+}
 
-        if (package_Sample_Num * PackageSampleBytes == recvPos) {
-          package_recvPos += recvPos;
-          break;
-        }
-      }
+void YDlidarDriver::trackMotorSpeed(uint64_t now) {
+  uint64_t interval = last_ring_time ? now - last_ring_time : 0;
+  uint64_t deviation = interval > ring_interval ? interval - ring_interval :
+                       ring_interval - interval;
+  //a revolution within 5% of the previous one, at the same reported speed.
+  bool steady = interval && ring_interval && deviation * 20 <= ring_interval &&
+                scan_frequence == ring_frequence;
 
-      if (package_Sample_Num * PackageSampleBytes != recvPos) {
-        return RESULT_FAIL;
-      }
-    } else {
-      return RESULT_FAIL;
+  if (!steady) {
+    stable_rings = 0;
+  } else if (stable_rings < MOTOR_STABLE_RINGS) {
+    stable_rings++;
+  }
+
+  last_ring_time = now;
+  ring_interval = interval;
+  ring_frequence = scan_frequence;
+
+  if (stable_rings >= MOTOR_STABLE_RINGS && !motor_ready) {
+    motor_ready = true;
+    motor_event.set();
+  }
+}
+
+bool YDlidarDriver::isMotorReady() const {
+  return motor_ready;
+}
+
+result_t YDlidarDriver::waitMotorReady(uint32_t timeout) {
+  if (!m_Threadless || m_ExternalLoop) {
+    return motor_event.wait(timeout) == Event::EVENT_OK ? RESULT_OK :
+           RESULT_TIMEOUT;
+  }
+
+  //no parsing thread, the caller's thread has to read the port meanwhile.
+  uint32_t start = getms();
+
+  while (!motor_ready && isScanning) {
+    uint32_t elapsed = getms() - start;
+
+    if (elapsed >= timeout) {
+      break;
     }
 
-    CheckSumCal ^= SampleNumlAndCTCal;
-    CheckSumCal ^= LastSampleAngleCal;
+    waitForData(1, min(timeout - elapsed, (uint32_t)10));
 
-    if (CheckSumCal != CheckSum) {
-      CheckSumResult = false;
-      has_package_error = true;
-    } else {
-      CheckSumResult = true;
+    if (!IS_OK(processReadable())) {
+      break;
+    }
+  }
+
+  return motor_ready ? RESULT_OK : RESULT_TIMEOUT;
+}
+
+void YDlidarDriver::waitSerialQuiet(uint32_t timeout) {
+  //a few packages of silence, the stream has really ended then.
+  uint32_t quiet = min(getDataTimeout(), (uint32_t)MOTOR_QUIET_TIME);
+  uint32_t start = getms();
+
+  while (isConnected && getms() - start < timeout) {
+    size_t size = 0;
+
+    if (waitForData(1, quiet, &size) != RESULT_OK) {
+      return;
     }
 
+    discardData(_comm, _comm->available());
   }
+}
 
+void YDlidarDriver::parsePackageNode(node_info *node) {
+  int32_t  AngleCorrectForDistance    = 0;
   uint8_t package_CT;
 
   if (m_intensities) {
@@ -1051,106 +1418,350 @@ result_t YDlidarDriver::waitPackage(node_info *node, uint32_t timeout) {
     nowPackageNum = packages.nowPackageNum;
   }
 
-  package_Sample_Index++;
+  package_Sample_Index++;
+
+  if (package_Sample_Index >= nowPackageNum) {
+    package_Sample_Index = 0;
+    CheckSumResult = false;
+  }
+
+}
+
+result_t YDlidarDriver::waitScanData(node_info *nodebuffer, size_t &count,
+                                     uint32_t timeout) {
+  if (!isConnected) {
+    count = 0;
+    return RESULT_FAIL;
+  }
+
+  size_t     recvNodeCount    =  0;
+  uint32_t   startTs          = getms();
+  uint32_t   waitTime         = 0;
+  result_t   ans              = RESULT_FAIL;
+
+  while ((waitTime = getms() - startTs) <= timeout && recvNodeCount < count) {
+    node_info node;
+    ans = waitPackage(&node, timeout - waitTime);
+
+    if (!IS_OK(ans)) {
+      count = recvNodeCount;
+      return ans;
+    }
+
+    nodebuffer[recvNodeCount++] = node;
+
+    if (node.sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT) {
+      nodebuffer[recvNodeCount - 1].stamp = getPendingDelay(_comm->available());
+      nodebuffer[recvNodeCount - 1].scan_frequence = node.scan_frequence;
+      count = recvNodeCount;
+      return RESULT_OK;
+    }
+
+    //a finished package is handed on at once, as in threadless mode, so the
+    //scan window follows the device package by package.
+    if (package_Sample_Index == 0 || recvNodeCount == count) {
+      count = recvNodeCount;
+      return RESULT_OK;
+    }
+  }
+
+  count = recvNodeCount;
+  return RESULT_TIMEOUT;
+}
+
+
+uint64_t YDlidarDriver::getPendingDelay(size_t size) const {
+  uint64_t delayTime = 0;
+  size_t PackageSize = (m_intensities ? INTENSITY_NORMAL_PACKAGE_SIZE :
+                        NORMAL_PACKAGE_SIZE);
+
+  if (size > PackagePaidBytes && size < PackagePaidBytes * PackageSize) {
+    size_t packageNum = size / PackageSize;
+    size_t Number = size % PackageSize;
+    delayTime = packageNum * m_PointTime * PackageSize / 2;
+
+    if (Number > PackagePaidBytes) {
+      delayTime += m_PointTime * ((Number - PackagePaidBytes) / 2);
+    }
+
+    size = Number;
+
+    if (packageNum > 0 && Number == 0) {
+      size = PackageSize;
+    }
+  }
+
+  return size * trans_delay + delayTime;
+}
+
+result_t YDlidarDriver::grabScanData(node_info *nodebuffer, size_t &count,
+                                     uint32_t timeout) {
+  if (m_Threadless && !m_ExternalLoop) {
+    uint32_t startTs = getms();
+    uint32_t waitTime = 0;
+
+    while (scan_node_count == 0 && isScanning &&
+           (waitTime = getms() - startTs) <= timeout) {
+      size_t recvSize = 0;
+      waitForData(PackagePaidBytes, timeout - waitTime, &recvSize);
+
+      if (!IS_OK(processReadable())) {
+        break;
+      }
+    }
+
+    timeout = 0;
+  }
+
+  switch (_dataEvent.wait(timeout)) {
+    case Event::EVENT_TIMEOUT:
+      count = 0;
+      return RESULT_TIMEOUT;
+
+    case Event::EVENT_OK: {
+      if (scan_node_count == 0) {
+        return RESULT_FAIL;
+      }
+
+      ScopedLocker l(_lock);
+      //drained under the lock, so a scan published after this copy re-arms it.
+      _scanNotify.clear();
+      size_t size_to_copy = min(count, scan_node_count);
+      memcpy(nodebuffer, scan_node_buf, size_to_copy * sizeof(node_info));
+      count = size_to_copy;
+      scan_node_count = 0;
+      scan_stats.delivered++;
+    }
+
+    return RESULT_OK;
+
+    default:
+      count = 0;
+      return RESULT_FAIL;
+  }
+
+}
+
+result_t YDlidarDriver::processReadable(size_t *scans) {
+  node_info local_buf[PackageSampleMaxLngth];
+  size_t    scan_count = 0;
+
+  if (scans) {
+    *scans = 0;
+  }
+
+  if (!isConnected) {
+    return RESULT_FAIL;
+  }
+
+  //paused by ::pauseScan, whose caller reads the answers to its commands.
+  if (!isScanning) {
+    return scan_paused ? RESULT_OK : RESULT_FAIL;
+  }
+
+  size_t size = _comm->available();
+
+  while (size > 0) {
+    size_t recvSize = min(size, packageRemainSize());
+
+    if (!IS_OK(getData(globalRecvBuffer, recvSize))) {
+      return RESULT_FAIL;
+    }
+
+    size -= recvSize;
+    bool received = false;
+
+    for (size_t pos = 0; pos < recvSize; ++pos) {
+      if (parsePackageByte(globalRecvBuffer[pos])) {
+        received = true;
+      }
+    }
+
+    if (!received) {
+      continue;
+    }
+
+    size_t count = 0;
+
+    do {
+      parsePackageNode(&local_buf[count++]);
+    } while (package_Sample_Index != 0 && count < PackageSampleMaxLngth);
+
+    local_buf[count - 1].stamp = getPendingDelay(size);
+
+    for (size_t pos = 0; pos < count; ++pos) {
+      if (local_buf[pos].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT) {
+        local_buf[pos].stamp = local_buf[count - 1].stamp +
+                               (count - 1 - pos) * m_PointTime;
+      }
+    }
+
+    scan_count += handleScanNodes(local_buf, count);
+  }
+
+  if (scans) {
+    *scans = scan_count;
+  }
+
+  checkWatchdog();
+  return RESULT_OK;
+}
+
+result_t YDlidarDriver::discardReadable() {
+  if (!isConnected) {
+    return RESULT_FAIL;
+  }
+
+  discardData(_comm, _comm->available());
+  return RESULT_OK;
+}
+
+uint32_t YDlidarDriver::getReconnectCount() const {
+  return reconnect_count;
+}
+
+void YDlidarDriver::setStallCallback(const StallCallback &callback) {
+  m_stallCallback = callback;
+}
+
+uint32_t YDlidarDriver::getDataTimeout() const {
+  uint8_t samples = max_package_samples;
+
+  if (!samples) {
+    return DEFAULT_TIMEOUT;
+  }
+
+  uint64_t timeout = WATCHDOG_PACKAGES * samples * (uint64_t)m_PointTime /
+                     1000000;
+  return static_cast<uint32_t>(std::max<uint64_t>(std::min<uint64_t>(timeout,
+                               DEFAULT_TIMEOUT), WATCHDOG_MIN_TIMEOUT));
+}
+
+bool YDlidarDriver::checkWatchdog() {
+  if (!isScanning) {
+    return false;
+  }
+
+  bool stalled = getTime() - last_package_time > 1000000ULL * getDataTimeout();
+
+  if (stalled == data_stalled) {
+    return stalled;
+  }
+
+  data_stalled = stalled;
+
+  if (stalled) {
+    //the revolution in progress spans the gap, drop it.
+    local_scan[0].sync_flag = Node_NotSync;
+    fprintf(stderr, "[YDlidarDriver] no data for %u ms\n", getDataTimeout());
+  } else {
+    fprintf(stderr, "[YDlidarDriver] data resumed\n");
+  }
+
+  fflush(stderr);
+
+  if (m_stallCallback) {
+    m_stallCallback(stalled);
+  }
+
+  return stalled;
+}
+
+int YDlidarDriver::getFileDescriptor() {
+  ScopedLocker l(_serial_lock);
+
+  if (!_comm) {
+    return -1;
+  }
+
+  return _comm->getFileDescriptor();
+}
+
+result_t YDlidarDriver::setScanWindow(int bins) {
+  if (isScanning) {
+    return RESULT_FAIL;
+  }
+
+  std::shared_ptr<ScanWindow> window = std::atomic_load(&m_window);
+
+  if (window && bins > 0 && window->size() == (size_t)bins) {
+    return RESULT_OK;
+  }
+
+  //a snapshot in progress keeps the old window alive until it is done.
+  std::shared_ptr<ScanWindow> next;
 
-  if (package_Sample_Index >= nowPackageNum) {
-    package_Sample_Index = 0;
-    CheckSumResult = false;
+  if (bins > 0) {
+    next = std::make_shared<ScanWindow>(bins);
   }
 
+  std::atomic_store(&m_window, next);
   return RESULT_OK;
 }
 
-result_t YDlidarDriver::waitScanData(node_info *nodebuffer, size_t &count,
-                                     uint32_t timeout) {
-  if (!isConnected) {
-    count = 0;
+result_t YDlidarDriver::getScanWindow(std::vector<ScanWindowBin> &bins) {
+  std::shared_ptr<ScanWindow> window = std::atomic_load(&m_window);
+
+  if (!window) {
+    bins.clear();
     return RESULT_FAIL;
   }
 
-  size_t     recvNodeCount    =  0;
-  uint32_t   startTs          = getms();
-  uint32_t   waitTime         = 0;
-  result_t   ans              = RESULT_FAIL;
-
-  while ((waitTime = getms() - startTs) <= timeout && recvNodeCount < count) {
-    node_info node;
-    ans = waitPackage(&node, timeout - waitTime);
-
-    if (!IS_OK(ans)) {
-      count = recvNodeCount;
-      return ans;
-    }
-
-    nodebuffer[recvNodeCount++] = node;
+  _sectorNotify.clear();
+  window->snapshot(bins, getTime());
+  return RESULT_OK;
+}
 
-    if (node.sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT) {
-      size_t size = _serial->available();
-      uint64_t delayTime = 0;
-      size_t PackageSize = (m_intensities ? INTENSITY_NORMAL_PACKAGE_SIZE :
-                            NORMAL_PACKAGE_SIZE);
-
-      if (size > PackagePaidBytes && size < PackagePaidBytes * PackageSize) {
-        size_t packageNum = size / PackageSize;
-        size_t Number = size % PackageSize;
-        delayTime = packageNum * m_PointTime * PackageSize / 2;
-
-        if (Number > PackagePaidBytes) {
-          delayTime += m_PointTime * ((Number - PackagePaidBytes) / 2);
-        }
+int YDlidarDriver::getScanEventFd() const {
+  return _scanNotify.fd();
+}
 
-        size = Number;
+int YDlidarDriver::getSectorEventFd() const {
+  return _sectorNotify.fd();
+}
 
-        if (packageNum > 0 && Number == 0) {
-          size = PackageSize;
-        }
-      }
+int YDlidarDriver::addScanConsumer(OverrunPolicy policy, uint32_t block_ms,
+                                   size_t depth) {
+  return m_broadcast.addConsumer(policy, block_ms, depth);
+}
 
-      nodebuffer[recvNodeCount - 1].stamp = size * trans_delay + delayTime;
-      nodebuffer[recvNodeCount - 1].scan_frequence = node.scan_frequence;
-      count = recvNodeCount;
-      return RESULT_OK;
-    }
+void YDlidarDriver::removeScanConsumer(int id) {
+  m_broadcast.removeConsumer(id);
+}
 
-    if (recvNodeCount == count) {
-      return RESULT_OK;
-    }
+result_t YDlidarDriver::grabScanFrame(int id,
+                                      std::shared_ptr<const ScanFrame> &frame,
+                                      uint32_t timeout, uint64_t *lost) {
+  if (m_Threadless && !m_ExternalLoop) {
+    //nothing but the caller's own event loop feeds the broadcast, waiting
+    //here would starve it. An external loop runs on another thread.
+    timeout = 0;
   }
 
-  count = recvNodeCount;
-  return RESULT_FAIL;
+  return m_broadcast.next(id, frame, timeout, lost);
 }
 
+result_t YDlidarDriver::grabScanFrames(int id,
+                                       std::vector<std::shared_ptr<const ScanFrame> > &frames,
+                                       size_t max, uint32_t timeout, uint64_t *lost) {
+  if (m_Threadless && !m_ExternalLoop) {
+    timeout = 0;
+  }
 
-result_t YDlidarDriver::grabScanData(node_info *nodebuffer, size_t &count,
-                                     uint32_t timeout) {
-  switch (_dataEvent.wait(timeout)) {
-    case Event::EVENT_TIMEOUT:
-      count = 0;
-      return RESULT_TIMEOUT;
-
-    case Event::EVENT_OK: {
-      if (scan_node_count == 0) {
-        return RESULT_FAIL;
-      }
-
-      ScopedLocker l(_lock);
-      size_t size_to_copy = min(count, scan_node_count);
-      memcpy(nodebuffer, scan_node_buf, size_to_copy * sizeof(node_info));
-      count = size_to_copy;
-      scan_node_count = 0;
-    }
+  return m_broadcast.drain(id, frames, max, timeout, lost);
+}
 
+result_t YDlidarDriver::getScanStats(int id, ScanConsumerStats &stats) {
+  if (id < 0) {
+    ScopedLocker l(_lock);
+    stats = scan_stats;
+    stats.pending = scan_node_count > 0 ? 1 : 0;
     return RESULT_OK;
-
-    default:
-      count = 0;
-      return RESULT_FAIL;
   }
 
+  return m_broadcast.getStats(id, stats) ? RESULT_OK : RESULT_FAIL;
 }
 
-
 result_t YDlidarDriver::ascendScanData(node_info *nodebuffer, size_t count) {
   float inc_origin_angle = (float)360.0 / count;
   int i = 0;
@@ -1401,7 +2012,7 @@ void YDlidarDriver::setAutoReconnect(const bool &enable) {
 
 void YDlidarDriver::checkTransDelay() {
   //calc stamp
-  trans_delay = _serial->getByteTime();
+  trans_delay = _comm->getByteTime();
   sample_rate = lidarModelDefaultSampleRate(model) * 1000;
 
   switch (model) {
@@ -1513,7 +2124,31 @@ result_t YDlidarDriver::stopScan(uint32_t timeout) {
 }
 
 result_t YDlidarDriver::createThread() {
-  _thread = CLASS_THREAD(YDlidarDriver, cacheScanData);
+  _wakeup.clear();
+  _cancelEvent.set(false);
+  m_broadcast.setClosed(false);
+  last_package_time = getTime();
+  max_package_samples = 0;
+  data_stalled = false;
+  last_ring_time = 0;
+  ring_interval = 0;
+  stable_rings = 0;
+  motor_ready = false;
+  motor_event.set(false);
+  //startScan already holds _lock and no parser is running yet.
+  memset(&scan_stats, 0, sizeof(scan_stats));
+  scan_node_count = 0;
+
+  if (m_Threadless) {
+    //the caller's event loop drives ::processReadable instead of a thread.
+    flushSerial();
+    resetScanParser();
+    isScanning = true;
+    return RESULT_OK;
+  }
+
+  _thread = CLASS_THREAD_OPTIONS(YDlidarDriver, cacheScanData,
+                                 m_ThreadOptions);
 
   if (_thread.getHandle() == 0) {
     isScanning = false;
@@ -1561,8 +2196,9 @@ result_t YDlidarDriver::startAutoScan(bool force, uint32_t timeout) {
 
   }
 
+  //the parsing thread calls this itself, its watchdog covers the spin-up.
   if (isSupportMotorCtrl(model)) {
-    startMotor();
+    setMotorEnable(true);
   }
 
   return RESULT_OK;
@@ -1587,6 +2223,54 @@ result_t YDlidarDriver::stop() {
   return RESULT_OK;
 }
 
+/************************************************************************/
+/*  pause and continue scanning                                         */
+/************************************************************************/
+result_t YDlidarDriver::pauseScan() {
+  if (!isConnected) {
+    return RESULT_FAIL;
+  }
+
+  scan_paused = true;
+  disableDataGrabbing();
+  return stopScan();
+}
+
+result_t YDlidarDriver::continueScan(uint32_t timeout) {
+  result_t ans = RESULT_FAIL;
+
+  if (isConnected && !isScanning) {
+    flushSerial();
+    ScopedLocker l(_lock);
+    ans = sendCommand(LIDAR_CMD_SCAN);
+
+    if (IS_OK(ans) && !m_SingleChannel) {
+      lidar_ans_header response_header;
+      ans = waitResponseHeader(&response_header, timeout);
+
+      if (IS_OK(ans) && (response_header.type != LIDAR_ANS_TYPE_MEASUREMENT ||
+                         response_header.size < 5)) {
+        ans = RESULT_FAIL;
+      }
+    }
+
+    if (IS_OK(ans)) {
+      ans = createThread();
+    }
+  }
+
+  scan_paused = false;
+
+  if (!IS_OK(ans)) {
+    m_broadcast.setClosed(true);
+    return ans;
+  }
+
+  //the motor never stopped, this only waits out a speed change.
+  waitMotorReady(MOTOR_READY_TIMEOUT);
+  return RESULT_OK;
+}
+
 /************************************************************************/
 /*  reset device                                                        */
 /************************************************************************/
@@ -1611,33 +2295,41 @@ result_t YDlidarDriver::reset(uint32_t timeout) {
 /*  startMotor                                                          */
 /************************************************************************/
 result_t YDlidarDriver::startMotor() {
+  setMotorEnable(true);
+
+  if (!isScanning) {
+    //no data to judge the speed by.
+    delay(DEFAULT_MOTOR_DELAY);
+    return RESULT_OK;
+  }
+
+  //never longer than the fixed delay it replaces.
+  return waitMotorReady(MOTOR_READY_TIMEOUT);
+}
+
+void YDlidarDriver::setMotorEnable(bool on) {
   ScopedLocker l(_lock);
 
-  if (isSupportMotorDtrCtrl) {
+  if (isSupportMotorDtrCtrl == on) {
     setDTR();
-    delay(500);
   } else {
     clearDTR();
-    delay(500);
   }
-
-  return RESULT_OK;
 }
 
 /************************************************************************/
 /*  stopMotor                                                           */
 /************************************************************************/
 result_t YDlidarDriver::stopMotor() {
-  ScopedLocker l(_lock);
+  setMotorEnable(false);
 
-  if (isSupportMotorDtrCtrl) {
-    clearDTR();
-    delay(500);
-  } else {
-    setDTR();
-    delay(500);
+  if (isScanning) {
+    //the parsing thread owns the port.
+    delay(DEFAULT_MOTOR_DELAY);
+    return RESULT_OK;
   }
 
+  waitSerialQuiet(DEFAULT_MOTOR_DELAY);
   return RESULT_OK;
 }
 
@@ -1984,13 +2676,327 @@ result_t YDlidarDriver::getZeroOffsetAngle(offset_angle &angle,
   return RESULT_OK;
 }
 
+/************************************************************************/
+/*  low power mode and motor state                                      */
+/************************************************************************/
+result_t YDlidarDriver::enableLowPower(function_state &state,
+                                       uint32_t timeout) {
+  return sendStateCommand(LIDAR_CMD_ENABLE_LOW_POWER, state, timeout);
+}
+
+result_t YDlidarDriver::disableLowPower(function_state &state,
+                                        uint32_t timeout) {
+  return sendStateCommand(LIDAR_CMD_DISABLE_LOW_POWER, state, timeout);
+}
+
+result_t YDlidarDriver::getMotorState(function_state &state,
+                                      uint32_t timeout) {
+  return sendStateCommand(LIDAR_CMD_STATE_MODEL_MOTOR, state, timeout);
+}
+
+result_t YDlidarDriver::sendStateCommand(uint8_t cmd, function_state &state,
+    uint32_t timeout) {
+  result_t  ans;
+
+  if (!isConnected || m_SingleChannel) {
+    return RESULT_FAIL;
+  }
+
+  disableDataGrabbing();
+  flushSerial();
+  {
+    ScopedLocker l(_lock);
+
+    if ((ans = sendCommand(cmd)) != RESULT_OK) {
+      return ans;
+    }
+
+    lidar_ans_header response_header;
+
+    if ((ans = waitResponseHeader(&response_header, timeout)) != RESULT_OK) {
+      return ans;
+    }
+
+    if (response_header.type != LIDAR_ANS_TYPE_DEVINFO) {
+      return RESULT_FAIL;
+    }
+
+    if (response_header.size < sizeof(function_state)) {
+      return RESULT_FAIL;
+    }
+
+    if (waitForData(response_header.size, timeout) != RESULT_OK) {
+      return RESULT_FAIL;
+    }
+
+    getData(reinterpret_cast<uint8_t *>(&state), sizeof(state));
+  }
+  return RESULT_OK;
+}
+
 
 
 std::string YDlidarDriver::getSDKVersion() {
   return SDKVerision;
 }
+namespace {
+/// 自动识别时依次尝试的波特率, 常用的排在前面
+const uint32_t kDetectBaudrates[] = {230400, 512000, 128000, 115200, 153600};
+
+/*!
+ * 校验 buf 起始处的一个 0x55AA 数据包
+ * @return 校验通过返回包长, 否则返回 0
+ */
+size_t checkDetectPackage(const uint8_t *buf, size_t size, int sample_bytes) {
+  if (size < PackagePaidBytes || buf[0] != (PH & 0xFF) || buf[1] != (PH >> 8)) {
+    return 0;
+  }
+
+  uint8_t sample_num = buf[3];
+  uint16_t first_angle = buf[4] | (buf[5] << 8);
+  uint16_t last_angle = buf[6] | (buf[7] << 8);
+
+  if (sample_num == 0 ||
+      !(first_angle & LIDAR_RESP_MEASUREMENT_CHECKBIT) ||
+      !(last_angle & LIDAR_RESP_MEASUREMENT_CHECKBIT)) {
+    return 0;
+  }
+
+  size_t length = PackagePaidBytes + sample_num * sample_bytes;
+
+  if (size < length) {
+    return 0;
+  }
+
+  uint16_t check = PH ^ (buf[2] | (buf[3] << 8)) ^ first_angle ^ last_angle;
+
+  for (size_t i = PackagePaidBytes; i < length; i += sample_bytes) {
+    if (sample_bytes == 3) {
+      check ^= buf[i];
+      check ^= buf[i + 1] | (buf[i + 2] << 8);
+    } else {
+      check ^= buf[i] | (buf[i + 1] << 8);
+    }
+  }
+
+  return check == (buf[8] | (buf[9] << 8)) ? length : 0;
+}
+
+/*!
+ * 按带/不带信号质量两种包长统计校验通过的数据包
+ * @return 识别出的每个激光点字节数, 未识别返回 0
+ */
+int detectPackageLayout(const std::vector<uint8_t> &data) {
+  for (int sample_bytes = 2; sample_bytes <= 3; sample_bytes++) {
+    int valid = 0;
+    size_t pos = 0;
+
+    while (pos + PackagePaidBytes <= data.size()) {
+      size_t length = checkDetectPackage(&data[pos], data.size() - pos,
+                                         sample_bytes);
+
+      if (length) {
+        valid++;
+        pos += length;
+      } else {
+        pos++;
+      }
+    }
+
+    if (valid >= 2) {
+      return sample_bytes;
+    }
+  }
+
+  return 0;
+}
+
+/*!
+ * 读取串口数据, 直到 timeout 到期或已读到 max_size 字节
+ */
+void detectListen(serial::Serial &serial, uint32_t timeout,
+                  std::vector<uint8_t> &data, size_t max_size = 4096) {
+  uint32_t start = getms();
+  uint8_t buf[512];
+
+  while (data.size() < max_size) {
+    uint32_t elapsed = getms() - start;
+
+    if (elapsed >= timeout) {
+      break;
+    }
+
+    size_t size = 0;
+
+    if (serial.waitfordata(1, timeout - elapsed, &size) != 0) {
+      break;
+    }
+
+    size = serial.read(buf, std::min(sizeof(buf), std::max<size_t>(size, 1)));
+    data.insert(data.end(), buf, buf + size);
+  }
+}
+
+/*!
+ * 发送获取设备信息命令, 在应答中查找 0xA5 0x5A 设备信息包头
+ */
+bool detectDeviceInfo(serial::Serial &serial, device_info &info,
+                      uint32_t timeout) {
+  uint8_t cmd[2] = {LIDAR_CMD_SYNC_BYTE, LIDAR_CMD_GET_DEVICE_INFO};
+  const size_t reply_size = sizeof(lidar_ans_header) + sizeof(device_info);
+  std::vector<uint8_t> data;
+
+  serial.flushInput();
+
+  if (serial.write(cmd, sizeof(cmd)) != sizeof(cmd)) {
+    return false;
+  }
+
+  uint32_t start = getms();
+
+  while (getms() - start < timeout) {
+    detectListen(serial, timeout - (getms() - start), data, reply_size);
+
+    for (size_t pos = 0; pos + reply_size <= data.size(); pos++) {
+      const lidar_ans_header *header =
+        reinterpret_cast<const lidar_ans_header *>(&data[pos]);
+
+      if (header->syncByte1 == LIDAR_ANS_SYNC_BYTE1 &&
+          header->syncByte2 == LIDAR_ANS_SYNC_BYTE2 &&
+          header->type == LIDAR_ANS_TYPE_DEVINFO &&
+          header->size >= sizeof(device_info)) {
+        memcpy(&info, &data[pos + sizeof(lidar_ans_header)], sizeof(info));
+        return true;
+      }
+    }
+
+    if (data.size() >= reply_size) {
+      data.erase(data.begin(), data.end() - (reply_size - 1));
+    }
+  }
+
+  return false;
+}
+
+/*!
+ * 停止双通道雷达扫描, 并丢弃停止前发出的数据
+ */
+void detectStopScan(serial::Serial &serial) {
+  uint8_t cmd[2] = {LIDAR_CMD_SYNC_BYTE, LIDAR_CMD_STOP};
+  serial.write(cmd, sizeof(cmd));
+  uint32_t start = getms();
+
+  while (getms() - start < 100) {
+    std::vector<uint8_t> data;
+    detectListen(serial, 20, data);
+
+    if (data.empty()) {
+      break;
+    }
+  }
+}
+}
+
+result_t YDlidarDriver::detectLidar(const std::string &port,
+                                    LidarDetectInfo &info, uint32_t timeout) {
+  const size_t baudrate_count = sizeof(kDetectBaudrates) /
+                                sizeof(kDetectBaudrates[0]);
+  serial::Serial serial(port, kDetectBaudrates[0],
+                        serial::Timeout::simpleTimeout(DETECT_LISTEN_TIME));
+
+  info.baudrate = 0;
+  info.single_channel = false;
+  info.intensities = false;
+  info.lidar_type = TYPE_TRIANGLE;
+  info.model = -1;
+
+  if (!serial.open()) {
+    return RESULT_FAIL;
+  }
+
+  uint32_t start = getms();
+  bool motor_started = false;
+  bool found = false;
+  device_info devinfo;
+
+  for (size_t i = 0; !found && getms() - start < timeout; i++) {
+    uint32_t baudrate = kDetectBaudrates[i % baudrate_count];
+    //第一轮被动监听并查询设备信息, 之后拉高 DTR 唤醒静默的单通道雷达
+    bool query = i < baudrate_count;
+
+    if (i == baudrate_count) {
+      serial.setDTR(true);
+      motor_started = true;
+    }
+
+    if (!serial.setBaudrate(baudrate)) {
+      continue;
+    }
+
+    serial.flushInput();
+
+    if (!query) {
+      uint8_t cmd[2] = {LIDAR_CMD_SYNC_BYTE, LIDAR_CMD_SCAN};
+      serial.write(cmd, sizeof(cmd));
+    }
+
+    std::vector<uint8_t> data;
+    detectListen(serial, DETECT_LISTEN_TIME, data);
+    int sample_bytes = detectPackageLayout(data);
+
+    if (sample_bytes) {
+      found = true;
+      info.baudrate = baudrate;
+      info.intensities = sample_bytes == 3;
+      detectStopScan(serial);
+      info.single_channel = !detectDeviceInfo(serial, devinfo,
+                                              DETECT_REPLY_TIME);
+    } else if (query && detectDeviceInfo(serial, devinfo, DETECT_REPLY_TIME)) {
+      found = true;
+      info.baudrate = baudrate;
+      info.single_channel = false;
+      info.intensities = hasIntensity(devinfo.model);
+    }
+  }
+
+  if (motor_started) {
+    serial.setDTR(false);
+  }
+
+  serial.closePort();
+
+  if (!found) {
+    return RESULT_TIMEOUT;
+  }
+
+  if (!info.single_channel) {
+    info.model = devinfo.model;
+
+    if (isTOFLidarByModel(devinfo.model)) {
+      info.lidar_type = TYPE_TOF;
+    }
+  }
+
+  return RESULT_OK;
+}
+
+/// 进程内共享的雷达端口表
+static PortTable &lidarPortTable() {
+  static PortTable table;
+  return table;
+}
+
+std::vector<PortInfo> YDlidarDriver::lidarPortInfoList(
+  const std::string &serial_number) {
+  return lidarPortTable().ports(serial_number);
+}
+
+void YDlidarDriver::setLidarAdapters(const std::vector<std::string> &vid_pids) {
+  lidarPortTable().setAdapters(vid_pids);
+}
+
 std::map<std::string, std::string>  YDlidarDriver::lidarPortList() {
-  std::vector<PortInfo> lst = list_ports();
+  std::vector<PortInfo> lst = lidarPortInfoList();
   std::map<std::string, std::string> ports;
 
   for (std::vector<PortInfo>::iterator it = lst.begin(); it != lst.end(); it++) {
@@ -0,0 +1,261 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * YDlidarDriver::detectLidar against LiDARs simulated on a pseudo terminal:
+ * a streaming dual channel LiDAR, a single channel LiDAR with intensities,
+ * an idle dual channel LiDAR and a silent port.
+ */
+#include "ydlidar_driver.h"
+#include "test_util.h"
+#include <atomic>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace ydlidar;
+
+namespace {
+
+/// Streams scan packages and answers the commands detection sends.
+class SimLidar {
+ public:
+  SimLidar(bool streaming, bool answers, bool intensities)
+    : m_master(-1), m_streaming(streaming), m_answers(answers),
+      m_intensities(intensities), m_running(false), m_sync(false),
+      m_package(0) {
+  }
+
+  ~SimLidar() {
+    stop();
+
+    if (m_master >= 0) {
+      close(m_master);
+    }
+  }
+
+  bool start() {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+      return false;
+    }
+
+    m_port = ptsname(m_master);
+    fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK);
+    m_running = true;
+    m_thread = std::thread(&SimLidar::run, this);
+    return true;
+  }
+
+  void stop() {
+    if (m_running.exchange(false)) {
+      m_thread.join();
+    }
+  }
+
+  const std::string &port() const {
+    return m_port;
+  }
+
+ private:
+  void run() {
+    while (m_running) {
+      readCommands();
+
+      if (m_streaming) {
+        appendPackage();
+      }
+
+      if (!m_out.empty()) {
+        ssize_t size = write(m_master, m_out.data(), m_out.size());
+
+        if (size > 0) {
+          m_out.erase(m_out.begin(), m_out.begin() + size);
+        }
+      }
+
+      delay(2);
+    }
+  }
+
+  void readCommands() {
+    uint8_t buffer[64];
+    ssize_t size;
+
+    while ((size = read(m_master, buffer, sizeof(buffer))) > 0) {
+      for (ssize_t i = 0; i < size; i++) {
+        if (m_sync) {
+          handleCommand(buffer[i]);
+        }
+
+        m_sync = buffer[i] == LIDAR_CMD_SYNC_BYTE;
+      }
+    }
+  }
+
+  void handleCommand(uint8_t cmd) {
+    if (!m_answers) {
+      return;
+    }
+
+    switch (cmd) {
+      case LIDAR_CMD_GET_DEVICE_INFO: {
+        const uint8_t ans[] = {LIDAR_ANS_SYNC_BYTE1, LIDAR_ANS_SYNC_BYTE2,
+                               0x14, 0x00, 0x00, 0x00, LIDAR_ANS_TYPE_DEVINFO,
+                               YDLIDAR_G4, 0x04, 0x01, 0x01,
+                               2, 0, 2, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1
+                              };
+        m_out.insert(m_out.end(), ans, ans + sizeof(ans));
+      }
+      break;
+
+      case LIDAR_CMD_SCAN:
+      case LIDAR_CMD_FORCE_SCAN:
+        m_streaming = true;
+        break;
+
+      case LIDAR_CMD_STOP:
+      case LIDAR_CMD_FORCE_STOP:
+        m_streaming = false;
+        m_out.clear();
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  void appendPackage() {
+    const int count = 20;
+    bool ring_start = m_package == 0;
+    uint16_t ct = ring_start ? CT_RingStart : CT_Normal;
+    uint16_t first = m_package * 36 * 64;
+    uint16_t fsa = (first << 1) | LIDAR_RESP_MEASUREMENT_CHECKBIT;
+    uint16_t lsa = ((first + 19 * 64) << 1) | LIDAR_RESP_MEASUREMENT_CHECKBIT;
+    uint16_t cs = PH ^ fsa ^ lsa ^ (ct | (count << 8));
+    std::vector<uint8_t> body;
+
+    for (int i = 0; i < count; i++) {
+      uint16_t distance = static_cast<uint16_t>((2000 + i) << 2);
+
+      if (m_intensities) {
+        uint8_t quality = static_cast<uint8_t>(100 + i);
+        body.push_back(quality);
+        cs ^= quality;
+      }
+
+      body.push_back(distance & 0xFF);
+      body.push_back(distance >> 8);
+      cs ^= distance;
+    }
+
+    const uint8_t header[] = {PH & 0xFF, PH >> 8, static_cast<uint8_t>(ct),
+                              static_cast<uint8_t>(count),
+                              static_cast<uint8_t>(fsa), static_cast<uint8_t>(fsa >> 8),
+                              static_cast<uint8_t>(lsa), static_cast<uint8_t>(lsa >> 8),
+                              static_cast<uint8_t>(cs), static_cast<uint8_t>(cs >> 8)
+                             };
+    m_out.insert(m_out.end(), header, header + sizeof(header));
+    m_out.insert(m_out.end(), body.begin(), body.end());
+    m_package = (m_package + 1) % 10;
+  }
+
+  int m_master;
+  std::string m_port;
+  bool m_streaming;
+  bool m_answers;
+  bool m_intensities;
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+  bool m_sync;
+  int m_package;
+  std::vector<uint8_t> m_out;
+};
+
+void testStreamingDualChannel() {
+  SimLidar lidar(true, true, false);
+  CHECK(lidar.start());
+  LidarDetectInfo info;
+  CHECK_EQ(YDlidarDriver::detectLidar(lidar.port(), info, 1000), RESULT_OK);
+  CHECK(info.baudrate > 0);
+  CHECK(!info.single_channel);
+  CHECK(!info.intensities);
+  CHECK_EQ(info.model, YDLIDAR_G4);
+  CHECK_EQ(info.lidar_type, TYPE_TRIANGLE);
+}
+
+void testSingleChannelIntensities() {
+  SimLidar lidar(true, false, true);
+  CHECK(lidar.start());
+  LidarDetectInfo info;
+  CHECK_EQ(YDlidarDriver::detectLidar(lidar.port(), info, 1000), RESULT_OK);
+  CHECK(info.baudrate > 0);
+  CHECK(info.single_channel);
+  CHECK(info.intensities);
+  CHECK_EQ(info.model, -1);
+}
+
+void testIdleDualChannel() {
+  SimLidar lidar(false, true, false);
+  CHECK(lidar.start());
+  LidarDetectInfo info;
+  CHECK_EQ(YDlidarDriver::detectLidar(lidar.port(), info, 1000), RESULT_OK);
+  CHECK(info.baudrate > 0);
+  CHECK(!info.single_channel);
+  CHECK_EQ(info.model, YDLIDAR_G4);
+}
+
+void testSilentPort() {
+  SimLidar lidar(false, false, false);
+  CHECK(lidar.start());
+  LidarDetectInfo info;
+  uint32_t start = getms();
+  CHECK_EQ(YDlidarDriver::detectLidar(lidar.port(), info, 300), RESULT_TIMEOUT);
+  CHECK(getms() - start < 1000);
+  CHECK_EQ(info.baudrate, 0);
+
+  CHECK_EQ(YDlidarDriver::detectLidar("/dev/no_such_lidar", info, 300),
+           RESULT_FAIL);
+}
+
+}
+
+int main() {
+  testStreamingDualChannel();
+  testSingleChannelIntensities();
+  testIdleDualChannel();
+  testSilentPort();
+  TEST_EXIT();
+}
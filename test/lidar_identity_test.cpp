@@ -0,0 +1,118 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * LidarIdentity cache files and port lookup.
+ * Files are written to the working directory.
+ */
+#include "lidar_identity.h"
+#include "test_util.h"
+using namespace ydlidar;
+
+namespace {
+
+void writeFile(const std::string &file, const char *text) {
+  FILE *fp = fopen(file.c_str(), "w");
+
+  if (fp) {
+    fputs(text, fp);
+    fclose(fp);
+  }
+}
+
+void testFileName() {
+  CHECK(LidarIdentity::fileName("cache", "/dev/ttyUSB0") ==
+        "cache/_dev_ttyUSB0.identity");
+}
+
+void testRoundTrip() {
+  std::string file = LidarIdentity::fileName(".", "test_identity");
+  LidarIdentity saved;
+  saved.serial = "2020031100012345";
+  saved.usb_path = "1-1.2";
+  saved.usb_serial = "0001";
+  saved.port = "/dev/ttyUSB0";
+  CHECK(saved.save(file));
+
+  LidarIdentity loaded;
+  CHECK(loaded.load(file));
+  CHECK(loaded == saved);
+  remove(file.c_str());
+
+  //an identity without anything to locate the port by is useless.
+  writeFile(file, "version=1\nserial=1\nport=/dev/ttyUSB0\n");
+  CHECK(!loaded.load(file));
+  remove(file.c_str());
+}
+
+serial::PortInfo makePort(const char *port, const char *usb_path,
+                          const char *serial_number) {
+  serial::PortInfo info;
+  info.port = port;
+  info.usb_path = usb_path;
+  info.serial_number = serial_number;
+  return info;
+}
+
+void testLocate() {
+  LidarIdentity saved;
+  saved.usb_path = "1-1.2";
+  saved.usb_serial = "0001";
+  std::vector<serial::PortInfo> ports;
+  ports.push_back(makePort("/dev/ttyUSB0", "1-1.3", "0002"));
+  ports.push_back(makePort("/dev/ttyUSB1", "1-1.2", "0003"));
+  ports.push_back(makePort("/dev/ttyUSB2", "1-1.4", "0001"));
+
+  //the USB port wins over the adapter serial number.
+  CHECK_EQ(saved.locate(ports), 1);
+
+  //moved to another USB port, found by its unique adapter serial number.
+  saved.usb_path = "2-1";
+  CHECK_EQ(saved.locate(ports), 2);
+
+  //a serial number shared by several adapters identifies nothing.
+  ports.push_back(makePort("/dev/ttyUSB3", "1-1.5", "0001"));
+  CHECK_EQ(saved.locate(ports), -1);
+
+  saved.usb_serial.clear();
+  CHECK_EQ(saved.locate(ports), -1);
+}
+
+}
+
+int main() {
+  testFileName();
+  testRoundTrip();
+  testLocate();
+  TEST_EXIT();
+}
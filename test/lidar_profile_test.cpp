@@ -0,0 +1,166 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * LidarProfile cache files: file names, round trip and rejected files.
+ * Files are written to the working directory.
+ */
+#include "lidar_profile.h"
+#include "test_util.h"
+using namespace ydlidar;
+
+namespace {
+
+LidarProfile makeProfile() {
+  LidarProfile profile;
+  profile.serial = "2020031100012345";
+  profile.model = 6;
+  profile.lidar_type = 1;
+  profile.single_channel = false;
+  profile.intensities = true;
+  profile.major = 1;
+  profile.minor = 3;
+  profile.hardware = 2;
+  profile.requested_sample_rate = 9;
+  profile.requested_frequency = 10.f;
+  profile.sample_rate = 9;
+  profile.default_sample_rate = 5;
+  profile.scan_frequency = 9.8f;
+  profile.fixed_size = 918;
+  profile.point_time = 111111;
+  profile.angle_offset = -1.25f;
+  profile.angle_offset_corrected = true;
+  return profile;
+}
+
+void writeFile(const std::string &file, const char *text) {
+  FILE *fp = fopen(file.c_str(), "w");
+
+  if (fp) {
+    fputs(text, fp);
+    fclose(fp);
+  }
+}
+
+bool fileExists(const std::string &file) {
+  FILE *fp = fopen(file.c_str(), "r");
+
+  if (fp) {
+    fclose(fp);
+  }
+
+  return fp != NULL;
+}
+
+void testFileName() {
+  CHECK(LidarProfile::fileName("cache", "/dev/ttyUSB0") ==
+        "cache/_dev_ttyUSB0.profile");
+  CHECK(LidarProfile::fileName("cache/", "COM3:") == "cache/COM3_.profile");
+  CHECK(LidarProfile::fileName("", "123") == "123.profile");
+}
+
+void testProfileRoundTrip() {
+  std::string file = LidarProfile::fileName(".", "test_profile");
+  LidarProfile saved = makeProfile();
+  CHECK(saved.save(file));
+
+  LidarProfile loaded;
+  CHECK(loaded.load(file));
+  CHECK(loaded.serial == saved.serial);
+  CHECK_EQ(loaded.model, saved.model);
+  CHECK_EQ(loaded.lidar_type, saved.lidar_type);
+  CHECK(loaded.single_channel == saved.single_channel);
+  CHECK(loaded.intensities == saved.intensities);
+  CHECK_EQ(loaded.major, saved.major);
+  CHECK_EQ(loaded.minor, saved.minor);
+  CHECK_EQ(loaded.hardware, saved.hardware);
+  CHECK_EQ(loaded.requested_sample_rate, saved.requested_sample_rate);
+  CHECK_NEAR(loaded.requested_frequency, saved.requested_frequency, 1e-4);
+  CHECK_EQ(loaded.sample_rate, saved.sample_rate);
+  CHECK_EQ(loaded.default_sample_rate, saved.default_sample_rate);
+  CHECK_NEAR(loaded.scan_frequency, saved.scan_frequency, 1e-4);
+  CHECK_EQ(loaded.fixed_size, saved.fixed_size);
+  CHECK_EQ(loaded.point_time, saved.point_time);
+  CHECK_NEAR(loaded.angle_offset, saved.angle_offset, 1e-4);
+  CHECK(loaded.angle_offset_corrected == saved.angle_offset_corrected);
+
+  CHECK(loaded.matches(9, 10.f, false));
+  CHECK(loaded.matches(9, 10.001f, false));
+  CHECK(!loaded.matches(5, 10.f, false));
+  CHECK(!loaded.matches(9, 12.f, false));
+  CHECK(!loaded.matches(9, 10.f, true));
+  CHECK(!LidarProfile().matches(0, 0.f, false));
+
+  //saving again replaces the file and leaves no temporary behind.
+  saved.fixed_size = 920;
+  CHECK(saved.save(file));
+  CHECK(loaded.load(file));
+  CHECK_EQ(loaded.fixed_size, 920);
+  CHECK(!fileExists(file + ".tmp"));
+  remove(file.c_str());
+
+  CHECK(!loaded.load(file));
+}
+
+void testProfileRejected() {
+  std::string file = LidarProfile::fileName(".", "test_rejected");
+  LidarProfile profile;
+
+  writeFile(file, "version=2\nserial=1\nsample_rate=9\nfixed_size=918\n"
+            "point_time=100\n");
+  CHECK(!profile.load(file));
+
+  writeFile(file, "version=1\nsample_rate=9\nfixed_size=918\npoint_time=100\n");
+  CHECK(!profile.load(file));
+
+  //negotiated values missing, nothing usable.
+  writeFile(file, "version=1\nserial=1\nsample_rate=9\n");
+  CHECK(!profile.load(file));
+
+  //unknown keys and CRLF line ends are fine.
+  writeFile(file, "version=1\r\nserial=1\r\nsample_rate=9\r\nfixed_size=918\r\n"
+            "point_time=100\r\nnext_version_key=1\r\n");
+  CHECK(profile.load(file));
+  CHECK(profile.serial == "1");
+  CHECK_EQ(profile.fixed_size, 918);
+  remove(file.c_str());
+}
+
+}
+
+int main() {
+  testFileName();
+  testProfileRoundTrip();
+  testProfileRejected();
+  TEST_EXIT();
+}
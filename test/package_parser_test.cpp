@@ -0,0 +1,210 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * Package parser regression: a generated recording is replayed unpaced
+ * and looped through the file:// channel, and every revolution grabbed in
+ * threadless mode is compared against what was encoded.
+ *
+ * Revolution r carries a ring start package and kPackages packages of
+ * kSamples samples; sample i of package k lies at k * 30 + i * 0.75 degrees
+ * and measures 1000 * (r + 1) + 40 * k + i mm. Package kBadPackage of
+ * revolution kBadRevolution has a wrong checksum, and some noise precedes
+ * revolution 1.
+ */
+#include "ydlidar_driver.h"
+#include "test_util.h"
+#include <vector>
+using namespace ydlidar;
+
+namespace {
+
+const int kRevolutions = 4;
+const int kPackages = 12;
+const int kSamples = 40;
+const int kBadRevolution = 2;
+const int kBadPackage = 5;
+const uint16_t kPackageAngle = 30 * 64;
+const uint16_t kSampleAngle = 48;
+
+uint16_t sampleDistance(int revolution, int package, int sample) {
+  return static_cast<uint16_t>(1000 * (revolution + 1) + 40 * package + sample);
+}
+
+void appendPackage(std::vector<uint8_t> &out, bool ringStart,
+                   const std::vector<uint16_t> &distances, uint16_t first,
+                   uint16_t last, bool corrupt) {
+  uint16_t ct = ringStart ? (CT_RingStart | (100 << 1)) : CT_Normal;
+  uint16_t count = static_cast<uint16_t>(distances.size());
+  uint16_t fsa = (first << 1) | LIDAR_RESP_MEASUREMENT_CHECKBIT;
+  uint16_t lsa = (last << 1) | LIDAR_RESP_MEASUREMENT_CHECKBIT;
+  uint16_t cs = PH ^ fsa ^ lsa ^ (ct | (count << 8));
+
+  for (size_t i = 0; i < distances.size(); i++) {
+    cs ^= distances[i] << 2;
+  }
+
+  if (corrupt) {
+    cs ^= 0x0100;
+  }
+
+  const uint8_t header[] = {PH & 0xFF, PH >> 8, static_cast<uint8_t>(ct),
+                            static_cast<uint8_t>(count),
+                            static_cast<uint8_t>(fsa), static_cast<uint8_t>(fsa >> 8),
+                            static_cast<uint8_t>(lsa), static_cast<uint8_t>(lsa >> 8),
+                            static_cast<uint8_t>(cs), static_cast<uint8_t>(cs >> 8)
+                           };
+  out.insert(out.end(), header, header + sizeof(header));
+
+  for (size_t i = 0; i < distances.size(); i++) {
+    uint16_t sample = distances[i] << 2;
+    out.push_back(sample & 0xFF);
+    out.push_back(sample >> 8);
+  }
+}
+
+bool writeRecording(const std::string &file) {
+  //the answer to the scan command opens every recording.
+  std::vector<uint8_t> out = {LIDAR_ANS_SYNC_BYTE1, LIDAR_ANS_SYNC_BYTE2,
+                              0x05, 0x00, 0x00, 0x40, LIDAR_ANS_TYPE_MEASUREMENT
+                             };
+
+  for (int r = 0; r < kRevolutions; r++) {
+    if (r == 1) {
+      const uint8_t noise[] = {0x12, PH & 0xFF, 0x34, PH >> 8, 0xFF};
+      out.insert(out.end(), noise, noise + sizeof(noise));
+    }
+
+    appendPackage(out, true, std::vector<uint16_t>(1, sampleDistance(r, 0, 0)),
+                  0, 0, false);
+
+    for (int k = 0; k < kPackages; k++) {
+      std::vector<uint16_t> distances;
+
+      for (int i = 0; i < kSamples; i++) {
+        distances.push_back(sampleDistance(r, k, i));
+      }
+
+      uint16_t first = k * kPackageAngle;
+      appendPackage(out, false, distances, first,
+                    first + (kSamples - 1) * kSampleAngle,
+                    r == kBadRevolution && k == kBadPackage);
+    }
+  }
+
+  FILE *fp = fopen(file.c_str(), "wb");
+
+  if (!fp) {
+    return false;
+  }
+
+  bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+  return fclose(fp) == 0 && ok;
+}
+
+/// @return the revolution the scan was encoded as, -1 if it does not match
+int checkScan(const node_info *nodes, size_t count) {
+  CHECK_EQ(count, 1 + kPackages * kSamples);
+
+  if (count != 1 + kPackages * kSamples) {
+    return -1;
+  }
+
+  CHECK(nodes[0].sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT);
+  int revolution = (nodes[0].distance_q2 >> 2) / 1000 - 1;
+  CHECK(revolution >= 0 && revolution < kRevolutions);
+  int mismatches = 0;
+
+  for (int k = 0; k < kPackages; k++) {
+    for (int i = 0; i < kSamples; i++) {
+      const node_info &node = nodes[1 + k * kSamples + i];
+      bool bad = revolution == kBadRevolution && k == kBadPackage;
+      uint16_t distance = bad ? 0 : sampleDistance(revolution, k, i);
+      uint16_t angle = bad ? 0 : k * kPackageAngle + i * kSampleAngle;
+
+      if (node.sync_flag & LIDAR_RESP_MEASUREMENT_SYNCBIT ||
+          (node.distance_q2 >> 2) != distance ||
+          (node.angle_q6_checkbit >> LIDAR_RESP_MEASUREMENT_ANGLE_SHIFT) != angle) {
+        mismatches++;
+      }
+    }
+  }
+
+  CHECK_EQ(mismatches, 0);
+  return mismatches ? -1 : revolution;
+}
+
+}
+
+int main() {
+  std::string file = "package_parser_test.bin";
+  CHECK(writeRecording(file));
+
+  YDlidarDriver driver;
+  driver.setThreadless(true);
+  //no angle correction by distance, so angles are exact.
+  driver.setLidarType(TYPE_TOF);
+  std::string uri = "file://" + file + "?fast&loop";
+  CHECK_EQ(driver.connect(uri.c_str(), 230400), RESULT_OK);
+  CHECK_EQ(driver.startScan(), RESULT_OK);
+
+  static node_info nodes[YDlidarDriver::MAX_SCAN_NODES];
+  int last = -1;
+  int bad_seen = 0;
+
+  for (int n = 0; n < 3 * kRevolutions; n++) {
+    size_t count = YDlidarDriver::MAX_SCAN_NODES;
+
+    if (driver.grabScanData(nodes, count, 1000) != RESULT_OK) {
+      CHECK(!"grabScanData timed out");
+      break;
+    }
+
+    int revolution = checkScan(nodes, count);
+
+    //nothing skipped, the loop starts over at revolution 0.
+    if (last >= 0 && revolution >= 0) {
+      CHECK_EQ(revolution, (last + 1) % kRevolutions);
+    }
+
+    bad_seen += revolution == kBadRevolution;
+    last = revolution;
+  }
+
+  CHECK(bad_seen >= 2);
+
+  driver.stop();
+  driver.disconnect();
+  remove(file.c_str());
+  TEST_EXIT();
+}
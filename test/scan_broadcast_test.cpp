@@ -0,0 +1,228 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * ScanBroadcast delivery, overrun policies, accounting and shutdown.
+ */
+#include "scan_broadcast.h"
+#include "test_util.h"
+#include <string.h>
+#include <thread>
+using namespace ydlidar;
+
+namespace {
+
+typedef std::shared_ptr<const ScanFrame> FramePtr;
+
+uint64_t publishScan(ScanBroadcast &broadcast, uint16_t distance) {
+  node_info nodes[3];
+  memset(nodes, 0, sizeof(nodes));
+
+  for (int i = 0; i < 3; i++) {
+    nodes[i].distance_q2 = distance;
+  }
+
+  return broadcast.publish(nodes, 3, distance);
+}
+
+void testEveryConsumerGetsEveryFrame() {
+  ScanBroadcast broadcast(4);
+  CHECK_EQ(broadcast.consumerCount(), 0);
+  int a = broadcast.addConsumer();
+  int b = broadcast.addConsumer();
+  CHECK(a != b);
+  CHECK_EQ(broadcast.consumerCount(), 2);
+
+  CHECK_EQ(publishScan(broadcast, 100), 1);
+  CHECK_EQ(publishScan(broadcast, 200), 2);
+
+  FramePtr fa, fb;
+  uint64_t lost = 1;
+  CHECK_EQ(broadcast.next(a, fa, 0, &lost), RESULT_OK);
+  CHECK_EQ(broadcast.next(b, fb, 0), RESULT_OK);
+  CHECK_EQ(lost, 0);
+
+  if (fa && fb) {
+    //shared, not copied.
+    CHECK(fa == fb);
+    CHECK_EQ(fa->seq, 1);
+    CHECK_EQ(fa->stamp, 100);
+    CHECK_EQ(fa->nodes.size(), 3);
+    CHECK_EQ(fa->nodes[2].distance_q2, 100);
+  }
+
+  std::vector<FramePtr> frames;
+  CHECK_EQ(broadcast.drain(a, frames, 8, 0), RESULT_OK);
+  CHECK_EQ(frames.size(), 1);
+  CHECK_EQ(broadcast.next(a, fa, 0), RESULT_TIMEOUT);
+  CHECK_EQ(broadcast.next(b, fb, 0), RESULT_OK);
+
+  if (fb) {
+    CHECK_EQ(fb->seq, 2);
+  }
+
+  //a late consumer only sees what is published after it registered.
+  int c = broadcast.addConsumer();
+  FramePtr fc;
+  CHECK_EQ(broadcast.next(c, fc, 0), RESULT_TIMEOUT);
+  publishScan(broadcast, 300);
+  CHECK_EQ(broadcast.next(c, fc, 0), RESULT_OK);
+
+  if (fc) {
+    CHECK_EQ(fc->seq, 3);
+  }
+}
+
+void testDropOldest() {
+  ScanBroadcast broadcast;
+  int id = broadcast.addConsumer(OVERRUN_DROP_OLDEST, 0, 2);
+
+  for (int i = 1; i <= 5; i++) {
+    publishScan(broadcast, i);
+  }
+
+  ScanConsumerStats stats;
+  CHECK(broadcast.getStats(id, stats));
+  CHECK_EQ(stats.produced, 5);
+  CHECK_EQ(stats.overwritten, 3);
+  CHECK_EQ(stats.pending, 2);
+  CHECK_EQ(stats.delivered, 0);
+
+  FramePtr frame;
+  uint64_t lost = 0;
+  CHECK_EQ(broadcast.next(id, frame, 0, &lost), RESULT_OK);
+  CHECK_EQ(lost, 3);
+
+  if (frame) {
+    CHECK_EQ(frame->seq, 4);
+  }
+
+  CHECK(broadcast.getStats(id, stats));
+  CHECK_EQ(stats.produced, stats.delivered + stats.overwritten + stats.pending);
+}
+
+void testDropNewest() {
+  ScanBroadcast broadcast;
+  int id = broadcast.addConsumer(OVERRUN_DROP_NEWEST, 0, 2);
+
+  for (int i = 1; i <= 5; i++) {
+    publishScan(broadcast, i);
+  }
+
+  std::vector<FramePtr> frames;
+  uint64_t lost = 0;
+  CHECK_EQ(broadcast.drain(id, frames, 8, 0, &lost), RESULT_OK);
+  CHECK_EQ(frames.size(), 2);
+  CHECK_EQ(lost, 0);
+
+  if (frames.size() == 2) {
+    CHECK_EQ(frames[0]->seq, 1);
+    CHECK_EQ(frames[1]->seq, 2);
+  }
+
+  //the dropped frames show up as a gap on the next one.
+  publishScan(broadcast, 6);
+  FramePtr frame;
+  CHECK_EQ(broadcast.next(id, frame, 0, &lost), RESULT_OK);
+  CHECK_EQ(lost, 3);
+}
+
+void testBlock() {
+  ScanBroadcast broadcast;
+  int id = broadcast.addConsumer(OVERRUN_BLOCK, 50, 1);
+  publishScan(broadcast, 1);
+
+  //nobody reads, the producer gives up after the bound.
+  uint32_t start = getms();
+  publishScan(broadcast, 2);
+  CHECK(getms() - start >= 40);
+
+  ScanConsumerStats stats;
+  CHECK(broadcast.getStats(id, stats));
+  CHECK_EQ(stats.overwritten, 1);
+
+  //a reader frees the slot before the bound, nothing is lost.
+  std::thread reader([&]() {
+    delay(10);
+    FramePtr frame;
+    broadcast.next(id, frame, 100);
+  });
+  publishScan(broadcast, 3);
+  reader.join();
+  CHECK(broadcast.getStats(id, stats));
+  CHECK_EQ(stats.overwritten, 1);
+  CHECK_EQ(stats.pending, 1);
+}
+
+void testRemoveAndClose() {
+  ScanBroadcast broadcast;
+  int a = broadcast.addConsumer();
+  int b = broadcast.addConsumer();
+  FramePtr frame;
+
+  broadcast.removeConsumer(a);
+  CHECK_EQ(broadcast.consumerCount(), 1);
+  CHECK_EQ(broadcast.next(a, frame, 0), RESULT_FAIL);
+  ScanConsumerStats stats;
+  CHECK(!broadcast.getStats(a, stats));
+
+  //a removed id is reused.
+  CHECK_EQ(broadcast.addConsumer(), a);
+
+  //a waiting reader is woken by close, queued frames are still delivered.
+  publishScan(broadcast, 1);
+  std::thread closer([&]() {
+    delay(20);
+    broadcast.setClosed(true);
+  });
+  CHECK_EQ(broadcast.next(b, frame, 1000), RESULT_OK);
+  uint32_t start = getms();
+  CHECK_EQ(broadcast.next(b, frame, 1000), RESULT_FAIL);
+  CHECK(getms() - start < 500);
+  closer.join();
+
+  broadcast.setClosed(false);
+  publishScan(broadcast, 2);
+  CHECK_EQ(broadcast.next(b, frame, 0), RESULT_OK);
+}
+
+}
+
+int main() {
+  testEveryConsumerGetsEveryFrame();
+  testDropOldest();
+  testDropNewest();
+  testBlock();
+  testRemoveAndClose();
+  TEST_EXIT();
+}
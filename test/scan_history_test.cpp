@@ -0,0 +1,168 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * ScanHistory trimming, nearest/range lookups and rangeAt interpolation.
+ */
+#include "scan_history.h"
+#include "test_util.h"
+using namespace ydlidar;
+
+namespace {
+
+const uint64_t kMs = 1000000ULL;
+const uint64_t kBase = 1000 * kMs;
+const int kPoints = 360;
+const float kTimeIncrement = 1e-4f;
+
+/// one point per degree, point 180 at angle 0, every range the same.
+ScanHistory::ScanPtr makeScan(uint64_t stamp, float range) {
+  std::shared_ptr<LaserScan> scan = std::make_shared<LaserScan>();
+  scan->stamp = stamp;
+  scan->config.angle_increment = static_cast<float>(M_PI / 180.0);
+  scan->config.time_increment = kTimeIncrement;
+
+  for (int i = 0; i < kPoints; i++) {
+    LaserPoint point;
+    point.angle = (i - kPoints / 2) * scan->config.angle_increment;
+    point.range = range;
+    point.intensity = 0.f;
+    scan->points.push_back(point);
+  }
+
+  return scan;
+}
+
+void testDisabled() {
+  ScanHistory history;
+  CHECK_EQ(history.duration(), 0);
+  history.push(makeScan(kBase, 1.f));
+  CHECK_EQ(history.size(), 0);
+  CHECK(!history.nearest(kBase));
+}
+
+void testTrim() {
+  ScanHistory history(250 * kMs);
+
+  for (int i = 0; i <= 5; i++) {
+    history.push(makeScan(kBase + i * 100 * kMs, 1.f + i));
+  }
+
+  //only what lies within the duration before the newest scan is kept.
+  CHECK_EQ(history.size(), 3);
+
+  std::vector<ScanHistory::ScanPtr> scans;
+  history.range(0, kBase + 10000 * kMs, scans);
+  CHECK_EQ(scans.size(), 3);
+
+  if (scans.size() == 3) {
+    CHECK_EQ(scans[0]->stamp, kBase + 300 * kMs);
+    CHECK_EQ(scans[2]->stamp, kBase + 500 * kMs);
+  }
+
+  history.setDuration(100 * kMs);
+  CHECK_EQ(history.size(), 2);
+  CHECK_EQ(history.duration(), 100 * kMs);
+
+  //a scan older than the newest one means the clock jumped.
+  history.push(makeScan(kBase, 1.f));
+  CHECK_EQ(history.size(), 1);
+
+  history.clear();
+  CHECK_EQ(history.size(), 0);
+}
+
+void testNearestAndRange() {
+  ScanHistory history(1000 * kMs);
+
+  for (int i = 0; i < 5; i++) {
+    history.push(makeScan(kBase + i * 100 * kMs, 1.f + i));
+  }
+
+  CHECK_EQ(history.nearest(kBase + 140 * kMs)->stamp, kBase + 100 * kMs);
+  CHECK_EQ(history.nearest(kBase + 160 * kMs)->stamp, kBase + 200 * kMs);
+  CHECK_EQ(history.nearest(kBase + 300 * kMs)->stamp, kBase + 300 * kMs);
+  CHECK_EQ(history.nearest(0)->stamp, kBase);
+  CHECK_EQ(history.nearest(kBase + 9000 * kMs)->stamp, kBase + 400 * kMs);
+
+  std::vector<ScanHistory::ScanPtr> scans;
+  history.range(kBase + 100 * kMs, kBase + 300 * kMs, scans);
+  CHECK_EQ(scans.size(), 3);
+
+  if (scans.size() == 3) {
+    CHECK_EQ(scans[0]->stamp, kBase + 100 * kMs);
+    CHECK_EQ(scans[1]->stamp, kBase + 200 * kMs);
+    CHECK_EQ(scans[2]->stamp, kBase + 300 * kMs);
+  }
+
+  history.range(kBase + 110 * kMs, kBase + 190 * kMs, scans);
+  CHECK(scans.empty());
+}
+
+void testRangeAt() {
+  ScanHistory history(1000 * kMs);
+  history.push(makeScan(kBase, 2.f));
+  history.push(makeScan(kBase + 100 * kMs, 3.f));
+  history.push(makeScan(kBase + 200 * kMs, 4.f));
+
+  //angle 0 is point 180 of every scan, measured 18ms after its start.
+  uint64_t offset = static_cast<uint64_t>(180 * kTimeIncrement * 1e9);
+  float value = 0.f;
+
+  CHECK(history.rangeAt(0.f, kBase + offset, value));
+  CHECK_NEAR(value, 2.f, 1e-4);
+
+  CHECK(history.rangeAt(0.f, kBase + offset + 50 * kMs, value));
+  CHECK_NEAR(value, 2.5f, 1e-3);
+
+  CHECK(history.rangeAt(0.f, kBase + offset + 175 * kMs, value));
+  CHECK_NEAR(value, 3.75f, 1e-3);
+
+  //before the first and after the last measurement nothing is known.
+  CHECK(!history.rangeAt(0.f, kBase, value));
+  CHECK(!history.rangeAt(0.f, kBase + 300 * kMs, value));
+
+  //an invalid reading on either side is not interpolated.
+  history.push(makeScan(kBase + 300 * kMs, 0.f));
+  CHECK(!history.rangeAt(0.f, kBase + offset + 250 * kMs, value));
+}
+
+}
+
+int main() {
+  testDisabled();
+  testTrim();
+  testNearestAndRange();
+  testRangeAt();
+  TEST_EXIT();
+}
@@ -0,0 +1,84 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2020, EAIBOT, Inc.
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+/*
+ * Minimal checks for the self-checking test programs run by ctest.
+ * A failed check is reported on stderr and the test goes on, so one run
+ * lists every failure; TEST_EXIT turns the count into the exit status.
+ */
+#pragma once
+#include <math.h>
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                       \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,    \
+              #cond);                                                     \
+      test_failures++;                                                    \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                    \
+  do {                                                                    \
+    long long a_ = (long long)(a);                                        \
+    long long b_ = (long long)(b);                                        \
+    if (a_ != b_) {                                                       \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",   \
+              __FILE__, __LINE__, #a, #b, a_, b_);                        \
+      test_failures++;                                                    \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_NEAR(a, b, eps)                                             \
+  do {                                                                    \
+    double a_ = (a);                                                      \
+    double b_ = (b);                                                      \
+    if (!(fabs(a_ - b_) <= (eps))) {                                      \
+      fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %f != %f\n",     \
+              __FILE__, __LINE__, #a, #b, a_, b_);                        \
+      test_failures++;                                                    \
+    }                                                                     \
+  } while (0)
+
+#define TEST_EXIT()                                                       \
+  do {                                                                    \
+    if (test_failures) {                                                  \
+      fprintf(stderr, "%d check(s) failed\n", test_failures);             \
+      return 1;                                                           \
+    }                                                                     \
+    printf("all checks passed\n");                                        \
+    return 0;                                                             \
+  } while (0)